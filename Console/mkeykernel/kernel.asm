@@ -11,12 +11,14 @@ section .text
 
 global start
 global keyboard_handler
+global timer_handler
 global read_port
 global write_port
 global load_idt
 
 extern kmain 		;this is defined in the c file
 extern keyboard_handler_main
+extern timer_handler_main
 
 read_port:
 	mov edx, [esp + 4]
@@ -36,8 +38,19 @@ load_idt:
 	sti 				;turn on interrupts
 	ret
 
+; the handlers interrupt C code, so they keep every register it may be using
 keyboard_handler:                 
+	pushad
+	cld
 	call    keyboard_handler_main
+	popad
+	iretd
+
+timer_handler:
+	pushad
+	cld
+	call    timer_handler_main
+	popad
 	iretd
 
 start:
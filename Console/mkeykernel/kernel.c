@@ -3,6 +3,8 @@
  * License: GPL version 2 or higher http://www.gnu.org/licenses/gpl.html
  */
 #include "keyboard_map.h"
+#include "game.h"
+#include "backend.h"
 
 /* there are 25 lines each of 80 columns; each element takes 2 bytes */
 #define LINES 25
@@ -12,6 +14,10 @@
 
 #define KEYBOARD_DATA_PORT 0x60
 #define KEYBOARD_STATUS_PORT 0x64
+#define PIT_CHANNEL0_PORT 0x40
+#define PIT_COMMAND_PORT 0x43
+#define PIT_FREQUENCY 1193182
+#define TICKS_PER_SECOND 1000 // One timer interrupt per millisecond
 #define IDT_SIZE 256
 #define INTERRUPT_GATE 0x8e
 #define KERNEL_CODE_SEGMENT_OFFSET 0x08
@@ -22,28 +28,13 @@ typedef enum
 	true
 } bool; // define bool as enum to increase readability
 
-// These definitions are used to call colors by name using bios color codes. It increases readability.
-#define BLACK 0x00
-#define BLUE 0x01
-#define GREEN 0x02
-#define CYAN 0x03
-#define RED 0x04
-#define MAGENTA 0x05
-#define BROWN 0x06
-#define LIGHT_GRAY 0x07
-#define DARK_GRAY 0x08
-#define LIGHT_BLUE 0x09
-#define LIGHT_GREEN 0x0A
-#define LIGHT_CYAN 0x0B
-#define LIGHT_RED 0x0C
-#define LIGHT_MAGENTA 0x0D
-#define YELLOW 0x0E
-#define WHITE 0x0F
+// The color names in game.h have the same values as the bios color codes, so they are written to video memory as they are.
 
 // #define ENTER_KEY_CODE 0x1C
 
 extern unsigned char keyboard_map[128];
 extern void keyboard_handler(void);
+extern void timer_handler(void);
 extern char read_port(unsigned short port);
 extern void write_port(unsigned short port, unsigned char data);
 extern void load_idt(unsigned long *idt_ptr);
@@ -61,382 +52,201 @@ struct IDT_entry
 };
 struct IDT_entry IDT[IDT_SIZE];
 
-struct Space_Ship
-{
-	int x;
-	int y;
-};
+volatile char current_key = 0;
+volatile bool key_pressed = false;
+volatile unsigned int ticks = 0; // Milliseconds since the timer was started, counted by timer_handler_main
+unsigned int tsc_per_usec = 0;	 // Speed of the time-stamp counter, measured against the timer
 
-struct Bullet
-{
-	bool active;
-	int x;
-	int y;
-};
+/*
+The game itself lives in the shared core (Game/game.c), this file only
+connects it to the machine: a buffer copied to video memory for drawing, the keyboard
+interrupt for keys and the timer interrupt for time. Between frames
+the CPU halts until the next interrupt.
+*/
 
-#define NUMBER_OF_ASTEROIDS 3
-struct Asteroid
-{
-	bool active;
-	int x_start;
-	int x_end;
-	int y_start;
-	int y_end;
-	bool explode;
-	int phase;
-};
-struct Space_Ship space_ship;
-struct Bullet bullet;
-struct Asteroid asteroids[NUMBER_OF_ASTEROIDS];
-
-char current_key = 0;
-bool key_pressed = false;
-bool game_start = false;
-bool game_over = false;
-bool game_restart = false;
-bool game_pause = false;
-int life = 3;
-int score = 0;
-char Score[3];
-
-void init_space_ship() // Function that places space_ship in the bottom middle
-{
-	space_ship.x = (COLUMNS_IN_LINE - 5) / 2; // pos = middle bottom
-	space_ship.y = LINES - 2;
-}
+#define ARENA_SIZE (16 * 1024)
+char arena[ARENA_SIZE]; // There is no heap, the game takes its memory from here once at startup
+unsigned int arena_used = 0;
 
-void init_asteroids() // Function that clears and initializes the asteroids[]
+/*
+Drawing goes to screen, an off-screen copy of video memory. A row is
+marked in dirty_rows only when one of its cells really changes, so an
+object erased and drawn again at the same place costs nothing, and
+backend_present copies just the changed rows to video memory, once per
+frame, as whole dwords.
+*/
+unsigned short screen[LINES][COLUMNS_IN_LINE]; // [color] [character] of every cell
+unsigned int dirty_rows = 0;				   // Bit y is set when row y differs from video memory
+
+void kprint_at(int x, int y, const char *str, int color) // Function that places specific string and color at specific x and y coordinates into the screen buffer
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
+	if (y < 0 || y >= LINES)
+		return;
+	while (*str != '\0') // For each character
 	{
-		asteroids[i].active = false; // Disable all asteroids so they can be (re)spawn
+		if (x >= 0 && x < COLUMNS_IN_LINE) // Characters outside the screen are skipped
+		{
+			unsigned short cell = (unsigned char)*str | color << 8; //[' '] [color]
+			if (screen[y][x] != cell)
+			{
+				screen[y][x] = cell;
+				dirty_rows |= 1 << y;
+			}
+		}
+		str++;
+		x++;
 	}
 }
 
-void kprint_at(int x, int y, const char *str, int color) // Function that places specific string and color at specific x and y coordinates into video memory buffer
+void clear_screen() // Function that clears the screen
 {
-	// Calculate absolute index in video memory buffer
-	int index = BYTES_FOR_EACH_ELEMENT * (y * COLUMNS_IN_LINE + x);
-	while (*str != '\0') // For each character
-	{
-		//[' '] [color]
-		vidptr[index++] = *str++;
-		vidptr[index++] = color;
-	}
+	for (int y = 0; y < LINES; y++)
+		for (int x = 0; x < COLUMNS_IN_LINE; x++)
+			screen[y][x] = ' ' | BLACK << 8;
+	dirty_rows = (1 << LINES) - 1;
 }
 
-void clear_screen() // Function that clears the screen
+void flush_screen() // Function that copies the changed rows to video memory
 {
-	unsigned int i = 0;
-	while (i < SCREENSIZE) // Reset all elements of video buffer
+	for (int y = 0; y < LINES; y++)
 	{
-		//[' '] [color] is struct of each character in video buffer
-		vidptr[i++] = ' ';
-		vidptr[i++] = BLACK;
+		if (!(dirty_rows & 1 << y))
+			continue;
+		void *dst = vidptr + y * COLUMNS_IN_LINE * BYTES_FOR_EACH_ELEMENT;
+		const void *src = screen[y];
+		int dwords = COLUMNS_IN_LINE * BYTES_FOR_EACH_ELEMENT / 4;
+		__asm__ volatile("cld; rep movsl" : "+D"(dst), "+S"(src), "+c"(dwords) : : "memory");
 	}
+	dirty_rows = 0;
 }
 
-void game_init() // Function that initializes and resets all game variables
+void *backend_alloc(unsigned size)
 {
-	init_space_ship();
-	init_asteroids();
-	bullet.active = false;
-	clear_screen();
-	score = 0;
-	life = 3;
+	size = (size + 3) & ~3; // Keep everything 4 byte aligned
+	if (arena_used + size > ARENA_SIZE)
+		return 0;
+	void *ptr = arena + arena_used;
+	arena_used += size;
+	return ptr;
 }
 
-void print_score() // Function that writes the score in the upper right corner of the screen
+void backend_free(void *ptr)
 {
-	int temp = score;
-	for (int i = 2; i > -1; i--)
-	{
-		Score[i] = (char)temp % 10 + '0';
-		temp /= 10;
-	}
-	kprint_at(COLUMNS_IN_LINE - 9, 0, "Score:", LIGHT_CYAN);
-	kprint_at(COLUMNS_IN_LINE - 3, 0, Score, WHITE);
+	// Memory is only allocated once, when the game is created
 }
 
-void print_life() // Function that writes the life in the upper left corner of the screen
+void backend_clear(void)
 {
-	char life_char[2] = {(char)life + '0', '\0'};
-	kprint_at(0, 0, "Life:", LIGHT_GREEN);
-	kprint_at(5, 0, life_char, WHITE);
+	clear_screen();
 }
 
-void move_and_fire_space_ship() // Function that takes keyboard inputs and determines the movements of the spaceship and the starting point of the bullet according to these inputs
+void backend_erase(int x, int y, int w, int h)
 {
-	if (key_pressed)
-	{
-		switch (current_key) // If the same or a different key is pressed again
-		{
-		// case 'w':
-		// 	space_ship.y--;
-		// 	break;
-		// case 's':
-		// 	space_ship.y++;
-		// 	break;
-		case 'a':
-			if (space_ship.x > 1)
-				space_ship.x--;
-			break;
-		case 'd':
-			if (space_ship.x < COLUMNS_IN_LINE - 6)
-				space_ship.x++;
-			break;
-		case ' ':
-			if (!bullet.active) // If a bullet has been fired, a new bullet cannot be fired until that bullet hits something.
-			{
-				bullet.y = space_ship.y;
-				bullet.x = space_ship.x + 2;
-				bullet.active = true;
-			}
-			break;
-		case 'r':
-			game_restart = true;
-			break;
-		case 'p':
-			game_pause = true;
-			break;
-		}
-		key_pressed = false; // After the key is processed, the flag will be set to false so that it does not enter the same place again.
-	}
+	for (int i = 0; i < h; i++)
+		for (int j = 0; j < w; j++)
+			kprint_at(x + j, y + i, " ", BLACK);
 }
 
-void draw_space_ship(bool draw) // Function that draws and deletes the space_ship
+void backend_print(int x, int y, const char *str, int color)
 {
-	if (draw) // Draw space_ship if true
-	{
-		kprint_at(space_ship.x, space_ship.y, "/-^-\\", WHITE);
-	}
-	else // If false delete
-	{
-		kprint_at(space_ship.x - 1, space_ship.y, "       ", BLACK);
-	}
+	kprint_at(x, y, str, color);
 }
 
-void move_bullets() // Function that moves the bullet
+void backend_draw_ship(int x, int y, int w, int h)
 {
-	if (bullet.y > 1) // If the bullet doesn't reach the top, move the bullet up
-	{
-		bullet.y--;
-	}
-	else if (bullet.active) // If the bullet has reached the top and is active, deactivate the bullet so it can be fired again
-	{
-		bullet.active = false;
-	}
+	kprint_at(x, y, "/-^-\\", WHITE);
 }
 
-void draw_bullets(bool draw) //
+void backend_draw_bullet(int x, int y, int w, int h)
 {
-	if (draw && bullet.active) // Draw  bullet if the bullet is active and true
-	{
-		kprint_at(bullet.x, bullet.y, "|", YELLOW);
-	}
-	else // If false delete
-	{
-		kprint_at(bullet.x, bullet.y, " ", BLACK);
-	}
+	kprint_at(x, y, "|", YELLOW);
 }
 
-void spawn_asteroids() // Function that spawns passive asteroids from a random x location
+const char *asteroid_art[ASTEROID_PHASES][4] = { // Rows of each asteroid size, the box given by the core has the same size
+	{" ######", "########", "########", " ######"},
+	{" ####", "######", " ####"},
+	{"###", "###"},
+	{"##"}};
+
+const char *explosion_art[ASTEROID_PHASES][4] = {
+	{" \\\\|//", "\\\\\\\\////", "////\\\\\\\\", " //|\\\\"},
+	{" \\\\//", ">>><<<", " //\\\\"},
+	{"\\|/", "/|\\"},
+	{"><"}};
+
+void backend_draw_asteroid(int x, int y, int w, int h, int phase, int exploding)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		if (!asteroids[i].active)
-		{
-			asteroids[i].x_start = rand(1, COLUMNS_IN_LINE - 9); // 1 - (COLUMNS_IN_LINE-9) range
-			asteroids[i].y_start = 1;
-			asteroids[i].explode = false;
-			asteroids[i].phase = 0;
-			asteroids[i].active = true;
-			return;
-		}
-	}
+	for (int i = 0; i < h; i++)
+		kprint_at(x, y + i, exploding ? explosion_art[phase][i] : asteroid_art[phase][i], exploding ? RED : LIGHT_GRAY);
 }
 
-void move_asteroids()
+void backend_draw_fragment(int x, int y, int w, int h, int color)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		if (asteroids[i].active) // Active ones move
-		{
-			asteroids[i].y_start++;
-			if (asteroids[i].explode)
-			{
-				asteroids[i].explode = false; // Reset explosion status when you move
-				if (asteroids[i].phase < 3)	  // If the size of asteroid is not the smalles, reduce the size
-				{
-					asteroids[i].phase++; // increasing phase means decreasing size
-					asteroids[i].x_start++;
-				}
-				else // If it becomes the smallest, deactivate it
-					asteroids[i].active = false;
-			}
-			if (asteroids[i].y_end > LINES - 3) // If it reaches the bottom of the screen (below the spaceship), lose life and deactivate.
-			{
-				asteroids[i].active = false;
-				life--;
-			}
-		}
-	}
+	kprint_at(x, y, "*", color);
 }
 
-void draw_asteroid(int id, bool draw) // Function to draw a single Asteroid and determine its hitboxes
+void backend_present(void)
 {
-	if (asteroids[id].active)
-	{
-		switch (asteroids[id].phase) // Enter one of the cases depending on the phase of the active asteroids
-		{
-		case 0:
-			asteroids[id].x_end = asteroids[id].x_start + 7;
-			asteroids[id].y_end = asteroids[id].y_start + 3;
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, " ######", LIGHT_GRAY);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "########", LIGHT_GRAY);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "########", LIGHT_GRAY);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 3, " ######", LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, " \\\\|//", RED);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "\\\\\\\\////", RED);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "////\\\\\\\\", RED);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 3, " //|\\\\", RED);
-			}
-			else
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "       ", BLACK);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "        ", BLACK);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "        ", BLACK);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 3, "       ", BLACK);
-			}
-			break;
-
-		case 1:
-			asteroids[id].x_end = asteroids[id].x_start + 5;
-			asteroids[id].y_end = asteroids[id].y_start + 2;
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, " ####", LIGHT_GRAY);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "######", LIGHT_GRAY);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, " ####", LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, " \\\\//", RED);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, ">>><<<", RED);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, " //\\\\", RED);
-			}
-			else
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "     ", BLACK);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "      ", BLACK);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "     ", BLACK);
-			}
-			break;
-
-		case 2:
-			asteroids[id].x_end = asteroids[id].x_start + 2;
-			asteroids[id].y_end = asteroids[id].y_start + 1;
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "###", LIGHT_GRAY);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "###", LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "\\|/", RED);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "/|\\", RED);
-			}
-			else
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "   ", BLACK);
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "   ", BLACK);
-			}
-			break;
+	flush_screen();
+}
 
-		case 3:
-			asteroids[id].x_end = asteroids[id].x_start + 1;
-			asteroids[id].y_end = asteroids[id].y_start;
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "##", LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "><", RED);
-			}
-			else
-			{
-				kprint_at(asteroids[id].x_start, asteroids[id].y_start, "  ", BLACK);
-			}
-			break;
-		}
-	}
+int backend_read_key(void)
+{
+	if (!key_pressed)
+		return 0;
+	key_pressed = false; // After the key is read, the flag will be set to false so that it does not enter the same place again.
+	return (unsigned char)current_key;
 }
 
-void draw_asteroids(bool draw) // Function to draw all asteroids
+int backend_key_held(int key) // Only presses are kept by keyboard_handler_main
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		draw_asteroid(i, draw); // We draw them all one by one using the method
-	}
+	return 0;
 }
 
-bool check_collision(int x, int y, int x_start, int x_end, int y_start, int y_end) // Function that controls simple hitbox and point collision
+unsigned int get_cpu_timer_value() // Function that get the current value of the system timer
 {
-	if ((x >= x_start && x <= x_end) && (y >= y_start && y <= y_end))
-		return true;
-	return false;
+	unsigned int val;
+	__asm__ volatile("rdtsc" : "=a"(val)); // Get Read Time-Stamp Counter value using inline assembly
+	return val;
 }
 
-void collision_event() // Function that handles collisions and life checking
+void sleep_until(unsigned int deadline) // Halts until ticks reaches deadline or a key is pressed
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++) // Perform collision checks for all asteroids
-	{
-		if (check_collision(bullet.x, bullet.y, asteroids[i].x_start, asteroids[i].x_end, asteroids[i].y_start, asteroids[i].y_end) && bullet.active && asteroids[i].active)
-		{
-			bullet.active = false;
-			asteroids[i].explode = true;
-			score++;
-		}
-	}
-	if (life <= 0)
-		game_over = true;
+	/* Interrupts are only enabled by the sti right before hlt, so one
+	 that comes after the check still wakes the hlt instead of being missed. */
+	__asm__ volatile("cli");
+	while ((int)(ticks - deadline) < 0 && !key_pressed)
+		__asm__ volatile("sti; hlt; cli");
+	__asm__ volatile("sti");
 }
 
-static unsigned long next; // Random Seeder
+unsigned backend_millis(void)
+{
+	return ticks;
+}
 
-int rand(int start, int end) // Function that generate a pseudo-random integer
+void backend_wait(int millis)
 {
-	next = next * 1103515245 + 12345;
-	return (unsigned int)(next / 65536) % (end - start) + start;
+	if (millis == GAME_WAIT_KEY)
+		sleep_until(ticks + 0x7fffffff); // Practically forever, a key ends it
+	else if (millis > 0)
+		sleep_until(ticks + millis);
 }
 
-unsigned int get_cpu_timer_value() // Function that get the current value of the system timer
+unsigned backend_timer(void)
 {
-	unsigned int val;
-	__asm__ volatile("rdtsc" : "=a"(val)); // Get Read Time-Stamp Counter value using inline assembly
-	return val;
+	return get_cpu_timer_value();
 }
 
-void sleep(int milliseconds) // Sleep Method 1 milisecond ~ 0.8-1.0ms
+unsigned backend_timer_usec(unsigned cycles)
 {
-	unsigned int loop_count = (unsigned int)milliseconds * 150000;
-	for (unsigned int i = 0; i < loop_count; i++)
-		;
+	return tsc_per_usec ? cycles / tsc_per_usec : 0;
 }
 
 void idt_init(void)
 {
 	unsigned long keyboard_address;
+	unsigned long timer_address;
 	unsigned long idt_address;
 	unsigned long idt_ptr[2];
 
@@ -448,6 +258,14 @@ void idt_init(void)
 	IDT[0x21].type_attr = INTERRUPT_GATE;
 	IDT[0x21].offset_higherbits = (keyboard_address & 0xffff0000) >> 16;
 
+	/* populate IDT entry of the timer's interrupt */
+	timer_address = (unsigned long)timer_handler;
+	IDT[0x20].offset_lowerbits = timer_address & 0xffff;
+	IDT[0x20].selector = KERNEL_CODE_SEGMENT_OFFSET;
+	IDT[0x20].zero = 0;
+	IDT[0x20].type_attr = INTERRUPT_GATE;
+	IDT[0x20].offset_higherbits = (timer_address & 0xffff0000) >> 16;
+
 	/*     Ports
 	 *	 PIC1	PIC2
 	 *Command 0x20	0xA0
@@ -496,8 +314,35 @@ void idt_init(void)
 
 void kb_init(void)
 {
-	/* 0xFD is 11111101 - enables only IRQ1 (keyboard)*/
-	write_port(0x21, 0xFD);
+	/* 0xFC is 11111100 - enables only IRQ0 (timer) and IRQ1 (keyboard)*/
+	write_port(0x21, 0xFC);
+}
+
+void timer_init(void)
+{
+	unsigned int divisor = PIT_FREQUENCY / TICKS_PER_SECOND;
+
+	write_port(PIT_COMMAND_PORT, 0x36); // Channel 0, low then high byte, square wave
+	write_port(PIT_CHANNEL0_PORT, divisor & 0xff);
+	write_port(PIT_CHANNEL0_PORT, divisor >> 8);
+}
+
+void timer_calibrate(void) // Function that measures the time-stamp counter over 10 timer ticks
+{
+	unsigned int start_tick = ticks + 1;
+	while (ticks != start_tick) // Start on a tick boundary
+		;
+	unsigned int start = get_cpu_timer_value();
+	while (ticks != start_tick + 10)
+		;
+	tsc_per_usec = (get_cpu_timer_value() - start) / (10 * 1000000 / TICKS_PER_SECOND);
+}
+
+void timer_handler_main(void)
+{
+	/* write EOI */
+	write_port(0x20, 0x20);
+	ticks++;
 }
 
 void keyboard_handler_main(void)
@@ -523,84 +368,23 @@ void keyboard_handler_main(void)
 
 void kmain(void)
 {
+	struct game_config config;
+
 	idt_init();
+	timer_init();
 	kb_init();
-	next = get_cpu_timer_value(); // seeding next value using cpu_timer_value
-
-Restart_Game:
-	game_init(); // Init and Reset game variables
-
-	if (!game_start)
-		kprint_at((COLUMNS_IN_LINE - 11) / 2, LINES / 2, "Start Game", LIGHT_GRAY); // Appears only on first startup
-	game_start = true;
-
-	if (game_restart)
-	{ // Appears on every restart
-		kprint_at((COLUMNS_IN_LINE - 9) / 2, (LINES / 2) - 1, "Score:", LIGHT_CYAN);
-		kprint_at(((COLUMNS_IN_LINE - 9) / 2) + 6, (LINES / 2) - 1, Score, WHITE);
-		kprint_at((COLUMNS_IN_LINE - 13) / 2, LINES / 2, "Restart Game", LIGHT_GRAY);
-	}
-	game_restart = false;
+	timer_calibrate();
 
-	if (game_over)
-	{ // Appears on every gameover
-		kprint_at((COLUMNS_IN_LINE - 9) / 2, (LINES / 2) - 1, "Score:", LIGHT_CYAN);
-		kprint_at(((COLUMNS_IN_LINE - 9) / 2) + 6, (LINES / 2) - 1, Score, WHITE);
-		kprint_at((COLUMNS_IN_LINE - 10) / 2, LINES / 2, "Game Over", LIGHT_GRAY);
-	}
-	game_over = false;
-
-	for (int i = 0; i < 3; i++)
-		Score[i] = '0'; // Clear Score Array
-	int loop_step = 0;	// We create(reset) the loop counter to create delay.
-
-	kprint_at((COLUMNS_IN_LINE - 33) / 2, 1, "180101012 - Ibrahim Yusuf Cosgun", DARK_GRAY);
-
-Pause_Game:
-	if (game_pause)
-		kprint_at((COLUMNS_IN_LINE - 14) / 2, LINES / 2, "Continue Game", LIGHT_GRAY); // Appears every pause
-	game_pause = false;
-
-	kprint_at((COLUMNS_IN_LINE - 14) / 2, (LINES / 2) + 1, "Press [Enter]", DARK_GRAY); // Appears always
-
-	while (current_key != '\n' || !key_pressed) // Wait for [Enter] Key
-		;
-	clear_screen(); // Reset and Inıt video buffer
-	while (true)
+	game_config_text(&config, COLUMNS_IN_LINE, LINES);
+	struct game *game = game_create(&config, get_cpu_timer_value()); // seeding the random numbers using cpu_timer_value
+	if (!game)
 	{
-		if (game_restart || game_over) // Proper reset with goto in case of gameover or restart of the game
-			goto Restart_Game;
-
-		if (game_pause) // Pause by just freezing the screen without resetting game objects (Buffer is not a game object, it makes the printing process faster and in one piece.)
-			goto Pause_Game;
-
-		sleep(35); // Sleep 35ms
-
-		// Clear
-		draw_space_ship(false);
-		draw_bullets(false);
-		draw_asteroids(false);
-
-		// Move and do Events
-		move_and_fire_space_ship();
-		move_bullets();
-		if (loop_step++ % 90 == 0)
-		{
-			spawn_asteroids();
-		}
-		if (loop_step % 15 == 0)
-		{
-			move_asteroids();
-		}
-		collision_event();
-
-		// Print
-		draw_space_ship(true);
-		draw_bullets(true);
-		draw_asteroids(true);
-		print_score();
-		print_life();
+		kprint_at(0, 0, "Out of memory", LIGHT_RED);
+		flush_screen();
+		return;
 	}
+
+	game_run(game);
 	while (1)
-		;
+		__asm__ volatile("hlt"); // Nothing left to do but answer interrupts
 }
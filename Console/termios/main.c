@@ -1,19 +1,17 @@
-#include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 #include <termios.h>
+#include <time.h>
+#include "game.h"
+#include "backend.h"
 
 #define HEIGHT 25
 #define WIDTH 80
 #define SCREENSIZE WIDTH *HEIGHT // same screen size to kernel
 
-typedef enum
-{
-  false,
-  true
-} bool; // define bool as enum to increase readability
-
 const char *color_array[] = { // The part of the Ansi escape sequence that changes for color is \033[.;..m
     "0;30",
     "0;34",
@@ -32,517 +30,341 @@ const char *color_array[] = { // The part of the Ansi escape sequence that chang
     "1;33",
     "1;37"};
 
-// These definitions were used to call a color in the color array by its name. It increases readability.
-#define BLACK 0
-#define BLUE 1
-#define GREEN 2
-#define CYAN 3
-#define RED 4
-#define MAGENTA 5
-#define BROWN 6
-#define LIGHT_GRAY 7
-#define DARK_GRAY 8
-#define LIGHT_BLUE 9
-#define LIGHT_GREEN 10
-#define LIGHT_CYAN 11
-#define LIGHT_RED 12
-#define LIGHT_MAGENTA 13
-#define YELLOW 14
-#define WHITE 15
-
-struct Space_Ship
-{
-  int x;
-  int y;
-};
-
-struct Bullet
+/* The screen is kept as a grid of cells, each with a character and a color.
+ screen is the frame being drawn and shown is what the terminal displays now,
+ so presenting a frame only has to send the cells that differ between them.*/
+struct cell
 {
-  bool active;
-  int x;
-  int y;
+  char ch;
+  char color;
 };
 
-#define NUMBER_OF_ASTEROIDS 3
-struct Asteroid
-{
-  bool active;
-  int x_start;
-  int x_end;
-  int y_start;
-  int y_end;
-  bool explode;
-  int phase;
-};
-
-/* I imagined a structure that requires a total of 8 chars for each
-character on the screen to keep the colors in the buffer.
- Apart from this, I added a 1-char field to the end of each line and
- added '\n' to that field so that it moves to the next line.*/
-char screen_buffer[SCREENSIZE * 8 + HEIGHT];
-
-// Create global variables
-struct Space_Ship space_ship;
-struct Bullet bullet;
-struct Asteroid asteroids[NUMBER_OF_ASTEROIDS];
-
-char current_key;
-bool key_pressed = false;
-bool game_start = false;
-bool game_over = false;
-bool game_restart = false;
-bool game_pause = false;
-int life = 3;
-int score = 0;
-char Score[3];
-
-void init_space_ship() // Function that places space_ship in the bottom middle
-{
-  space_ship.x = (WIDTH - 5) / 2; // pos = middle bottom
-  space_ship.y = HEIGHT - 2;
-}
-
-void init_asteroids() // Function that clears and initializes the asteroids[]
-{
-  for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-  {
-    asteroids[i].active = false; // Disable all asteroids so they can be (re)spawn
-  }
-}
-
-void kprint_at(int x, int y, const char *str, int color) // Function that places specific string and color at specific x and y coordinates into screen_buffer
+struct cell screen[HEIGHT][WIDTH];
+struct cell shown[HEIGHT][WIDTH];
+int shown_valid = 0; // Cleared when the terminal contents are unknown, the next frame is sent whole
+
+/* Worst case output of one frame: a cursor move, a color change and the character for every cell.*/
+char output[SCREENSIZE * (8 + 7 + 1) + 16];
+
+/* Keys are read from stdin only when poll() says some are waiting, as many
+ as there are, and handed to the game one at a time from this buffer. stdin
+ itself is left blocking, its flags are shared with the shell.*/
+char key_buffer[64];
+int key_count = 0;
+int key_next = 0;
+int input_closed = 0;
+int timer_fd = -1; // Wakes backend_wait when the game has something to do
+struct termios original_term;
+
+/*
+The game itself lives in the shared core (Game/game.c), this file only
+connects it to the terminal: a grid of cells for drawing, stdin for
+keys and the system clock for time. It runs in a single thread that
+sleeps in poll() until a key arrives or the game's next deadline.
+*/
+
+void kprint_at(int x, int y, const char *str, int color) // Function that places specific string and color at specific x and y coordinates into the screen grid
 {
+  if (y < 0 || y >= HEIGHT)
+    return;
   while (*str != '\0') // For each character
   {
-    int index = (((y * WIDTH) + x) * 8) + 2 + y;
-    //['\033'] ['['] [ ] [ ] [ ] [ ] ['m'] [ ] Since we do not want to change the first 2 characters, we reach the beginning of the changing part of the color code with + 2.
-    const char *color_adress = color_array[color];
-    while (*color_adress != '\0') // For the character of the color of each character
+    if (x >= 0 && x < WIDTH) // Characters outside the screen are skipped
     {
-      screen_buffer[index++] = *color_adress++;
+      screen[y][x].ch = *str;
+      screen[y][x].color = color;
     }
-    screen_buffer[++index /*skip 'm'*/] = *str++; // After adding the colors, we skip 1 character and write our character in the char field before processing.
+    str++;
     x++;
   }
 }
 
-void clear_buffer() // Function that clears and initializes the screen_buffer
+void clear_buffer() // Function that clears the screen grid
 {
   for (int y = 0; y < HEIGHT; y++)
-  {
     for (int x = 0; x < WIDTH; x++)
     {
-      int index = ((y * WIDTH) + x) * 8 + y;
-      //['\033'] ['['] ['0'] [';'] ['3'] ['0'] ['m'] [' '] every char on screen contains 8 char for colorization
-      screen_buffer[index++] = '\033';
-      screen_buffer[index++] = '[';
-      screen_buffer[index++] = '0';
-      screen_buffer[index++] = ';';
-      screen_buffer[index++] = '3';
-      screen_buffer[index++] = '0';
-      screen_buffer[index++] = 'm';
-      screen_buffer[index] = ' ';
+      screen[y][x].ch = ' ';
+      screen[y][x].color = BLACK;
     }
-    screen_buffer[((y * WIDTH) + WIDTH) * 8 + y] = '\n'; // If we reached the end of the line  ['\033'] ['['] ['0'] [';'] ['3'] ['0'] ['m'] [' ']  We add 1 char ['\n'] to the end of this structure
-  }
 }
 
-void clear_screen() // Function that clears the screen
+int append(char *out, const char *str) // Function that copies a string to the output and returns its length
 {
-  printf("\033[2J\033[H"); // Ansii escape code that clears the entire screen
+  int n = 0;
+  while (str[n] != '\0')
+  {
+    out[n] = str[n];
+    n++;
+  }
+  return n;
 }
 
-void game_init() // Function that initializes and resets all game variables
+int append_number(char *out, int n) // Function that writes a small positive number in decimal
 {
-  init_space_ship();
-  init_asteroids();
-  bullet.active = false;
-  clear_screen();
-  clear_buffer();
-  score = 0;
-  life = 3;
+  int length = 0;
+  if (n >= 10)
+    length = append_number(out, n / 10);
+  out[length] = '0' + n % 10;
+  return length + 1;
 }
 
-void print_score() // Function that writes the score in the upper right corner of the screen
+int blank(int y, int from, int to) // Function that tells if the cells from..to-1 of a row are spaces, on the screen and in the frame
 {
-  int temp = score;
-  for (int i = 2; i > -1; i--)
-  {
-    Score[i] = (char)temp % 10 + '0';
-    temp /= 10;
-  }
-  kprint_at(WIDTH - 9, 0, "Score:", LIGHT_CYAN);
-  kprint_at(WIDTH - 3, 0, Score, WHITE);
+  for (int x = from; x < to; x++)
+    if (screen[y][x].ch != ' ' || shown[y][x].ch != ' ')
+      return 0;
+  return 1;
 }
 
-void print_life() // Function that writes the life in the upper left corner of the screen
+void print_screen() // Function that sends the cells changed since the last frame to the terminal, with a single write
 {
-  char life_char[2] = {(char)life + '0', '\0'};
-  kprint_at(0, 0, "Life:", LIGHT_GREEN);
-  kprint_at(5, 0, life_char, WHITE);
-}
+  int length = 0;
+  int cursor_x = -1, cursor_y = -1; // Unknown until the first move
+  int color = -1;
 
-void move_and_fire_space_ship() // Function that takes keyboard inputs and determines the movements of the spaceship and the starting point of the bullet according to these inputs
-{
-  if (key_pressed) // If the same or a different key is pressed again
+  if (!shown_valid)
+  {
+    length += append(output, "\033[2J"); // Ansii escape code that clears the entire screen
+    for (int y = 0; y < HEIGHT; y++)
+      for (int x = 0; x < WIDTH; x++)
+        shown[y][x].ch = ' ';
+    shown_valid = 1;
+  }
+
+  for (int y = 0; y < HEIGHT; y++)
   {
-    switch (current_key)
+    for (int x = 0; x < WIDTH; x++)
     {
-    // case 'w':
-    // 	space_ship.y--;
-    // 	break;
-    // case 's':
-    // 	space_ship.y++;
-    // 	break;
-    case 'a':
-      if (space_ship.x > 1)
-        space_ship.x--;
-      break;
-    case 'd':
-      if (space_ship.x < WIDTH - 6)
-        space_ship.x++;
-      break;
-    case ' ':
-      if (!bullet.active) // If a bullet has been fired, a new bullet cannot be fired until that bullet hits something.
+      struct cell *c = &screen[y][x];
+      if (c->ch == shown[y][x].ch && (c->color == shown[y][x].color || c->ch == ' '))
+        continue; // Unchanged, a space looks the same in every color
+
+      if (y == cursor_y && x > cursor_x && x - cursor_x < 6 && blank(y, cursor_x, x)) // Writing a few spaces is shorter than moving the cursor
+        while (cursor_x < x)
+        {
+          output[length++] = ' ';
+          cursor_x++;
+        }
+      if (x != cursor_x || y != cursor_y) // Move the cursor, unless the last character left it here
       {
-        bullet.y = space_ship.y;
-        bullet.x = space_ship.x + 2;
-        bullet.active = true;
+        length += append(output + length, "\033[");
+        length += append_number(output + length, y + 1);
+        output[length++] = ';';
+        length += append_number(output + length, x + 1);
+        output[length++] = 'H';
       }
-      break;
-    case 'r':
-      game_restart = true;
-      break;
-    case 'p':
-      game_pause = true;
-      break;
+      if (c->color != color && c->ch != ' ') // Runs of the same color share one color change
+      {
+        length += append(output + length, "\033[");
+        length += append(output + length, color_array[(int)c->color]);
+        output[length++] = 'm';
+        color = c->color;
+      }
+      output[length++] = c->ch;
+      shown[y][x] = *c;
+      cursor_x = x + 1;
+      cursor_y = y;
     }
-    key_pressed = false; // After the key is processed, the flag will be set to false so that it does not enter the same place again.
   }
-}
 
-void draw_space_ship(bool draw) // Function that draws and deletes the space_ship
-{
-  if (draw) // Draw space_ship if true
-  {
-    kprint_at(space_ship.x, space_ship.y, "/-^-\\", WHITE);
-  }
-  else // If false delete
+  for (int written = 0, n; written < length; written += n) // Normally one write, more only if the terminal is slow
   {
-    kprint_at(space_ship.x - 1, space_ship.y, "       ", BLACK);
+    n = write(STDOUT_FILENO, output + written, length - written);
+    if (n <= 0)
+      break;
   }
 }
 
-void move_bullets() // Function that moves the bullet
+void *backend_alloc(unsigned size)
 {
-  if (bullet.y > 1) // If the bullet doesn't reach the top, move the bullet up
-  {
-    bullet.y--;
-  }
-  else if (bullet.active) // If the bullet has reached the top and is active, deactivate the bullet so it can be fired again
-  {
-    bullet.active = false;
-  }
+  return malloc(size);
 }
 
-void draw_bullets(bool draw) //
+void backend_free(void *ptr)
 {
-  if (draw && bullet.active) // Draw  bullet if the bullet is active and true
-  {
-    kprint_at(bullet.x, bullet.y, "|", YELLOW);
-  }
-  else // If false delete
-  {
-    kprint_at(bullet.x, bullet.y, " ", BLACK);
-  }
+  free(ptr);
 }
 
-void spawn_asteroids() // Function that spawns passive asteroids from a random x location
+void backend_clear(void)
 {
-  for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-  {
-    if (!asteroids[i].active)
-    {
-      asteroids[i].x_start = rand() % (WIDTH - 9 - 1) + 1; // 1 - (Width-9) range
-      asteroids[i].y_start = 1;
-      asteroids[i].explode = false;
-      asteroids[i].phase = 0;
-      asteroids[i].active = true;
-      return;
-    }
-  }
+  clear_buffer();
+  shown_valid = 0;
 }
 
-void move_asteroids()
+void backend_erase(int x, int y, int w, int h)
 {
-  for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-  {
-    if (asteroids[i].active) // Active ones move
-    {
-      asteroids[i].y_start++;
-      if (asteroids[i].explode)
-      {
-        asteroids[i].explode = false; // Reset explosion status when you move
-        if (asteroids[i].phase < 3)   // If the size of asteroid is not the smalles, reduce the size
-        {
-          asteroids[i].phase++; // increasing phase means decreasing size
-          asteroids[i].x_start++;
-        }
-        else // If it becomes the smallest, deactivate it
-          asteroids[i].active = false;
-      }
-      if (asteroids[i].y_end > HEIGHT - 3) // If it reaches the bottom of the screen (below the spaceship), lose life and deactivate.
-      {
-        asteroids[i].active = false;
-        life--;
-      }
-    }
-  }
+  char spaces[WIDTH + 1];
+  if (w > WIDTH)
+    w = WIDTH;
+  for (int i = 0; i < w; i++)
+    spaces[i] = ' ';
+  spaces[w] = '\0';
+  for (int i = 0; i < h; i++)
+    kprint_at(x, y + i, spaces, BLACK);
 }
 
-void draw_asteroid(int id, bool draw) // Function to draw a single Asteroid and determine its hitboxes
+void backend_print(int x, int y, const char *str, int color)
 {
-  if (asteroids[id].active)
-  {
-    switch (asteroids[id].phase) // Enter one of the cases depending on the phase of the active asteroids
-    {
-    case 0:
-      asteroids[id].x_end = asteroids[id].x_start + 7;
-      asteroids[id].y_end = asteroids[id].y_start + 3;
-      // Determine size according to phase
-      if (draw && !asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, " ######", LIGHT_GRAY);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "########", LIGHT_GRAY);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "########", LIGHT_GRAY);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 3, " ######", LIGHT_GRAY);
-      }
-      else if (draw && asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, " \\\\|//", RED);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "\\\\\\\\////", RED);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "////\\\\\\\\", RED);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 3, " //|\\\\", RED);
-      }
-      else
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "       ", BLACK);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "        ", BLACK);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "        ", BLACK);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 3, "       ", BLACK);
-      }
-      break;
-
-    case 1:
-      asteroids[id].x_end = asteroids[id].x_start + 5;
-      asteroids[id].y_end = asteroids[id].y_start + 2;
-      // Determine size according to phase
-      if (draw && !asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, " ####", LIGHT_GRAY);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "######", LIGHT_GRAY);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, " ####", LIGHT_GRAY);
-      }
-      else if (draw && asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, " \\\\//", RED);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, ">>><<<", RED);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, " //\\\\", RED);
-      }
-      else
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "     ", BLACK);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "      ", BLACK);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 2, "     ", BLACK);
-      }
-      break;
+  kprint_at(x, y, str, color);
+}
 
-    case 2:
-      asteroids[id].x_end = asteroids[id].x_start + 2;
-      asteroids[id].y_end = asteroids[id].y_start + 1;
-      // Determine size according to phase
-      if (draw && !asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "###", LIGHT_GRAY);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "###", LIGHT_GRAY);
-      }
-      else if (draw && asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "\\|/", RED);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "/|\\", RED);
-      }
-      else
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "   ", BLACK);
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start + 1, "   ", BLACK);
-      }
-      break;
+void backend_draw_ship(int x, int y, int w, int h)
+{
+  kprint_at(x, y, "/-^-\\", WHITE);
+}
 
-    case 3:
-      asteroids[id].x_end = asteroids[id].x_start + 1;
-      asteroids[id].y_end = asteroids[id].y_start;
-      // Determine size according to phase
-      if (draw && !asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "##", LIGHT_GRAY);
-      }
-      else if (draw && asteroids[id].explode)
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "><", RED);
-      }
-      else
-      {
-        kprint_at(asteroids[id].x_start, asteroids[id].y_start, "  ", BLACK);
-      }
-      break;
-    }
-  }
+void backend_draw_bullet(int x, int y, int w, int h)
+{
+  kprint_at(x, y, "|", YELLOW);
 }
 
-void draw_asteroids(bool draw) // Function to draw all asteroids
+const char *asteroid_art[ASTEROID_PHASES][4] = { // Rows of each asteroid size, the box given by the core has the same size
+    {" ######", "########", "########", " ######"},
+    {" ####", "######", " ####"},
+    {"###", "###"},
+    {"##"}};
+
+const char *explosion_art[ASTEROID_PHASES][4] = {
+    {" \\\\|//", "\\\\\\\\////", "////\\\\\\\\", " //|\\\\"},
+    {" \\\\//", ">>><<<", " //\\\\"},
+    {"\\|/", "/|\\"},
+    {"><"}};
+
+void backend_draw_asteroid(int x, int y, int w, int h, int phase, int exploding)
 {
-  for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-  {
-    draw_asteroid(i, draw); // We draw them all one by one using the method
-  }
+  for (int i = 0; i < h; i++)
+    kprint_at(x, y + i, exploding ? explosion_art[phase][i] : asteroid_art[phase][i], exploding ? RED : LIGHT_GRAY);
 }
 
-bool check_collision(int x, int y, int x_start, int x_end, int y_start, int y_end) // Function that controls simple hitbox and point collision
+void backend_draw_fragment(int x, int y, int w, int h, int color)
 {
-  if ((x >= x_start && x <= x_end) && (y >= y_start && y <= y_end))
-    return true;
-  return false;
+  kprint_at(x, y, "*", color);
 }
 
-void collision_event() // Function that handles collisions and life checking
+void backend_present(void)
 {
-  for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++) // Perform collision checks for all asteroids
-  {
-    if (check_collision(bullet.x, bullet.y, asteroids[i].x_start, asteroids[i].x_end, asteroids[i].y_start, asteroids[i].y_end) && bullet.active && asteroids[i].active)
-    {
-      bullet.active = false;
-      asteroids[i].explode = true;
-      score++;
-    }
-  }
-  if (life <= 0)
-    game_over = true;
+  print_screen();
 }
 
-void *KeyListener(void *vargp) // Keyboard listener thread used instead of the keyboard_handler_main method in the kernel
+int backend_read_key(void)
 {
-  while (true)
+  struct pollfd fds = {STDIN_FILENO, POLLIN, 0};
+
+  if (key_next == key_count && !input_closed && poll(&fds, 1, 0) > 0) // Buffer used up, take everything that is waiting
   {
-    scanf("%c", &current_key); // Waiting user input (NonBlocking because thread wait.)
-    key_pressed = 1;           // It activates this flag instead of interrupt, thus interaction is made.
+    key_next = 0;
+    key_count = read(STDIN_FILENO, key_buffer, sizeof(key_buffer));
+    if (key_count == 0) // End of input
+      input_closed = 1;
+    if (key_count <= 0)
+      key_count = 0;
   }
-  return NULL;
+  if (key_next < key_count)
+  {
+    int key = (unsigned char)key_buffer[key_next++];
+    if (key == 3 || key == 4) // Ctrl-C and Ctrl-D arrive as plain bytes, ISIG and ICANON are off
+      return GAME_KEY_QUIT;
+    return key;
+  }
+  return input_closed ? GAME_KEY_QUIT : 0;
 }
 
-void init_term_mode() // Function that change terminal mode
+int backend_key_held(int key) // A terminal only sends key presses
 {
-  static struct termios origt, newt;
-
-  tcgetattr(STDIN_FILENO, &origt);
-  newt = origt;
-  newt.c_lflag &= ~(ICANON | ECHO);
-  /*A bit operation is performed that inverts the ICANON (disable canonical mode) and ECHO (disable echo) flags of the terminal we just created.
-  This prevents the input from being processed on a character-by-character basis and prevents the user from seeing what he entered.*/
-  tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+  return 0;
 }
 
-void print_screen() // Function that prints the buffer to the screen
+unsigned backend_millis(void)
 {
-  printf("%s", screen_buffer);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000 + now.tv_nsec / 1000000;
 }
 
-void main(void)
+void backend_wait(int millis) // Sleep in poll() until stdin is readable or the timer expires
 {
-  srand(time(NULL));
-  pthread_t thread_id;
-  pthread_create(&thread_id, NULL, KeyListener, NULL);
-  init_term_mode(); // disable ICANON ECHO
-
-Restart_Game:
-  game_init(); // Init and Reset game variables
-
-  if (!game_start)
-    kprint_at((WIDTH - 11) / 2, HEIGHT / 2, "Start Game", LIGHT_GRAY); // Appears only on first startup
-  game_start = true;
-
-  if (game_restart)
-  { // Appears on every restart
-    kprint_at((WIDTH - 9) / 2, (HEIGHT / 2) - 1, "Score:", LIGHT_CYAN);
-    kprint_at(((WIDTH - 9) / 2) + 6, (HEIGHT / 2) - 1, Score, WHITE);
-    kprint_at((WIDTH - 13) / 2, HEIGHT / 2, "Restart Game", LIGHT_GRAY);
-  }
-  game_restart = false;
+  struct pollfd fds[2];
+  int nfds = 1;
+
+  if (key_next < key_count || input_closed || millis == 0) // Already something to do
+    return;
 
-  if (game_over)
-  { // Appears on every gameover
-    kprint_at((WIDTH - 9) / 2, (HEIGHT / 2) - 1, "Score:", LIGHT_CYAN);
-    kprint_at(((WIDTH - 9) / 2) + 6, (HEIGHT / 2) - 1, Score, WHITE);
-    kprint_at((WIDTH - 10) / 2, HEIGHT / 2, "Game Over", LIGHT_GRAY);
+  fds[0].fd = STDIN_FILENO;
+  fds[0].events = POLLIN;
+  if (millis != GAME_WAIT_KEY)
+  {
+    struct itimerspec deadline = {{0, 0}, {millis / 1000, millis % 1000 * 1000000}}; // One shot
+    timerfd_settime(timer_fd, 0, &deadline, NULL);
+    fds[1].fd = timer_fd;
+    fds[1].events = POLLIN;
+    nfds = 2;
   }
-  game_over = false;
 
-  for (int i = 0; i < 3; i++)
-    Score[i] = '0';  // Clear Score Array
-  int loop_step = 0; // We create(reset) the loop counter to create delay.
+  if (poll(fds, nfds, -1) > 0 && nfds == 2 && (fds[1].revents & POLLIN))
+  {
+    unsigned long long expirations;
+    read(timer_fd, &expirations, sizeof(expirations));
+  }
+}
 
-  kprint_at((WIDTH - 33) / 2, 1, "180101012 - Ibrahim Yusuf Cosgun", DARK_GRAY);
+unsigned backend_timer(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
 
-Pause_Game:
-  if (game_pause)
-    kprint_at((WIDTH - 14) / 2, HEIGHT / 2, "Continue Game", LIGHT_GRAY); // Appears every pause
-  game_pause = false;
+unsigned backend_timer_usec(unsigned ticks)
+{
+  return ticks;
+}
 
-  kprint_at((WIDTH - 14) / 2, (HEIGHT / 2) + 1, "Press [Enter]", DARK_GRAY); // Appears always
-  print_screen();
+void restore_term_mode() // Show the cursor again and give the terminal back as it was found
+{
+  write(STDOUT_FILENO, "\033[0m\033[?25h\n", 11);
+  tcsetattr(STDIN_FILENO, TCSANOW, &original_term);
+}
 
-  while (current_key != '\n' || !key_pressed) // Wait for [Enter] Key
-    ;
-  clear_buffer(); // Reset and Inıt Buffer
-  clear_screen(); // Reset visible screen
-  while (1)
-  {
-    if (game_restart || game_over) // Proper reset with goto in case of gameover or restart of the game
-      goto Restart_Game;
-    if (game_pause) // Pause by just freezing the screen without resetting game objects (Buffer is not a game object, it makes the printing process faster and in one piece.)
-    {
-      clear_screen();
-      goto Pause_Game;
-    }
+void terminate(int sig) // Killed from outside, only async-signal-safe calls from here
+{
+  restore_term_mode();
+  _exit(128 + sig);
+}
 
-    usleep(35 * 1000); // Sleep 35ms
+void init_term_mode() // Function that change terminal mode
+{
+  struct termios newt;
 
-    // Clear
-    clear_screen();
+  tcgetattr(STDIN_FILENO, &original_term);
+  newt = original_term;
+  newt.c_lflag &= ~(ICANON | ECHO | ISIG);
+  /*A bit operation is performed that inverts the ICANON (disable canonical mode), ECHO (disable echo) and ISIG (Ctrl-C is read as a key) flags of the terminal we just created.
+  This prevents the input from being processed on a character-by-character basis and prevents the user from seeing what he entered.*/
+  tcsetattr(STDIN_FILENO, TCSANOW, &newt);
 
-    draw_space_ship(false);
-    draw_bullets(false);
-    draw_asteroids(false);
+  signal(SIGTERM, terminate);
+  signal(SIGHUP, terminate);
+}
 
-    // Move and do Events
-    move_and_fire_space_ship();
-    move_bullets();
-    if (loop_step++ % 90 == 0)
-    {
-      spawn_asteroids();
-    }
-    if (loop_step % 15 == 0)
-    {
-      move_asteroids();
-    }
-    collision_event();
-
-    // Print
-    draw_space_ship(true);
-    draw_bullets(true);
-    draw_asteroids(true);
-    print_score();
-    print_life();
-    
-    print_screen();
-  }
+int main(void)
+{
+  struct game_config config;
+
+  game_config_text(&config, WIDTH, HEIGHT);
+  struct game *game = game_create(&config, time(NULL));
+  if (!game)
+    return 1;
+
+  timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+  if (timer_fd < 0)
+    return 1;
+  init_term_mode(); // disable ICANON ECHO ISIG
+
+  write(STDOUT_FILENO, "\033[?25l", 6); // Hide the cursor, it would jump around the changed cells
+  game_run(game);
+  restore_term_mode();
+  close(timer_fd);
+  game_delete(game);
+  return 0;
 }
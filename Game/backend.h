@@ -0,0 +1,38 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+/*
+Everything the game core needs from the environment it runs in.
+Each target (the two kernels, the terminal and the SDL window, and
+the headless benchmark) implements these functions once, and the
+core in game.c never touches a screen, keyboard or clock directly.
+
+Coordinates and sizes are in the target's own units, pixels or
+text cells, as described by its struct game_config.
+*/
+
+// Memory, only used when the game is created
+void *backend_alloc(unsigned size);
+void backend_free(void *ptr);
+
+// Drawing. Objects are always given by their bounding box.
+void backend_clear(void);										// Clear the whole screen
+void backend_erase(int x, int y, int w, int h);					// Clear one area to the background
+void backend_print(int x, int y, const char *str, int color);	// Write a string with its top left corner at x, y
+void backend_draw_ship(int x, int y, int w, int h);
+void backend_draw_bullet(int x, int y, int w, int h);
+void backend_draw_asteroid(int x, int y, int w, int h, int phase, int exploding);
+void backend_draw_fragment(int x, int y, int w, int h, int color);
+void backend_present(void);										// Make the frame drawn so far visible
+
+// Input
+int backend_read_key(void);		 // Next key pressed as an ASCII character, 0 if none is waiting, or GAME_KEY_QUIT
+int backend_key_held(int key); // Whether the key is down right now, always 0 on backends that only see presses
+
+// Time
+unsigned backend_millis(void);				  // Milliseconds since some fixed point, used to pace the game
+void backend_wait(int millis);				  // Sleep until a key is pressed or about millis have passed, GAME_WAIT_KEY waits only for a key
+unsigned backend_timer(void);				  // Free running counter for measuring short intervals
+unsigned backend_timer_usec(unsigned ticks); // Convert a difference of two backend_timer values to microseconds
+
+#endif
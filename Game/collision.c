@@ -0,0 +1,252 @@
+#include "collision.h"
+#include "backend.h"
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+
+#define COLLISION_CIRCLE 0
+#define COLLISION_BOX    1
+
+struct collision_shape {
+	int kind;
+	int x, y;	/* circle center, or box top left corner */
+	int r;		/* circle radius */
+	int w, h;	/* box size */
+	int cx, cy;	/* center, used for bucketing */
+	int cell;
+	unsigned layer;
+	unsigned mask;
+	int id;
+};
+
+struct collision_grid {
+	int width;
+	int height;
+	int cell_size;
+	int cols;
+	int rows;
+	int capacity;
+	int count;
+	int nlarge;
+	struct collision_shape *shapes;
+	int *order;
+	int *large;
+	int *cell_start;
+};
+
+struct collision_grid *collision_grid_create(int width, int height, int cell_size, int capacity)
+{
+	struct collision_grid *c = backend_alloc(sizeof(*c));
+	if(!c) return 0;
+
+	c->width = width;
+	c->height = height;
+	c->cell_size = cell_size;
+	c->cols = (width + cell_size - 1) / cell_size;
+	c->rows = (height + cell_size - 1) / cell_size;
+	c->capacity = capacity;
+	c->count = 0;
+	c->nlarge = 0;
+
+	c->shapes = backend_alloc(sizeof(*c->shapes) * capacity);
+	c->order = backend_alloc(sizeof(*c->order) * capacity);
+	c->large = backend_alloc(sizeof(*c->large) * capacity);
+	c->cell_start = backend_alloc(sizeof(*c->cell_start) * (c->cols * c->rows + 1));
+
+	if(!c->shapes || !c->order || !c->large || !c->cell_start) {
+		collision_grid_delete(c);
+		return 0;
+	}
+
+	return c;
+}
+
+void collision_grid_delete(struct collision_grid *c)
+{
+	if(!c) return;
+	if(c->shapes) backend_free(c->shapes);
+	if(c->order) backend_free(c->order);
+	if(c->large) backend_free(c->large);
+	if(c->cell_start) backend_free(c->cell_start);
+	backend_free(c);
+}
+
+void collision_grid_clear(struct collision_grid *c)
+{
+	c->count = 0;
+	c->nlarge = 0;
+}
+
+static int collision_cell(struct collision_grid *c, int x, int y)
+{
+	int col = x / c->cell_size;
+	int row = y / c->cell_size;
+
+	/* Objects partly off screen are bucketed at the nearest edge. */
+	if(x < 0) col = 0;
+	if(y < 0) row = 0;
+	if(col >= c->cols) col = c->cols - 1;
+	if(row >= c->rows) row = c->rows - 1;
+
+	return row * c->cols + col;
+}
+
+static int collision_add(struct collision_grid *c, struct collision_shape *s, int extent)
+{
+	if(c->count >= c->capacity) return 0;
+
+	int i = c->count++;
+
+	if(2 * extent > c->cell_size) {
+		s->cell = -1;
+		c->large[c->nlarge++] = i;
+	} else {
+		s->cell = collision_cell(c, s->cx, s->cy);
+	}
+
+	c->shapes[i] = *s;
+	return 1;
+}
+
+int collision_add_circle(struct collision_grid *c, int x, int y, int r, unsigned layer, unsigned mask, int id)
+{
+	struct collision_shape s;
+	s.kind = COLLISION_CIRCLE;
+	s.x = s.cx = x;
+	s.y = s.cy = y;
+	s.r = r;
+	s.w = s.h = 0;
+	s.layer = layer;
+	s.mask = mask;
+	s.id = id;
+	return collision_add(c, &s, r);
+}
+
+int collision_add_box(struct collision_grid *c, int x, int y, int w, int h, unsigned layer, unsigned mask, int id)
+{
+	struct collision_shape s;
+	s.kind = COLLISION_BOX;
+	s.x = x;
+	s.y = y;
+	s.w = w;
+	s.h = h;
+	s.cx = x + w / 2;
+	s.cy = y + h / 2;
+	s.r = 0;
+	s.layer = layer;
+	s.mask = mask;
+	s.id = id;
+	return collision_add(c, &s, MAX(w, h) / 2 + 1);
+}
+
+static inline int clamp(int v, int lo, int hi)
+{
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static int circle_box_overlap(struct collision_shape *a, struct collision_shape *b)
+{
+	int dx = a->x - clamp(a->x, b->x, b->x + b->w - 1);
+	int dy = a->y - clamp(a->y, b->y, b->y + b->h - 1);
+	return dx * dx + dy * dy <= a->r * a->r;
+}
+
+static int collision_overlap(struct collision_shape *a, struct collision_shape *b)
+{
+	if(a->kind == COLLISION_CIRCLE && b->kind == COLLISION_CIRCLE) {
+		int dx = a->x - b->x;
+		int dy = a->y - b->y;
+		int rr = a->r + b->r;
+		return dx * dx + dy * dy <= rr * rr;
+	} else if(a->kind == COLLISION_BOX && b->kind == COLLISION_BOX) {
+		return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+	} else if(a->kind == COLLISION_CIRCLE) {
+		return circle_box_overlap(a, b);
+	} else {
+		return circle_box_overlap(b, a);
+	}
+}
+
+/*
+Consider shape i (which is asking) against shape j.
+When both shapes want each other, only the lower index reports.
+*/
+
+static int collision_test(struct collision_grid *c, int i, int j, struct collision_pair *pairs, int npairs, int max_pairs)
+{
+	struct collision_shape *a = &c->shapes[i];
+	struct collision_shape *b = &c->shapes[j];
+
+	if(i == j || npairs >= max_pairs) return npairs;
+	if(!(a->mask & b->layer)) return npairs;
+	if((b->mask & a->layer) && j < i) return npairs;
+	if(!collision_overlap(a, b)) return npairs;
+
+	pairs[npairs].a = a->id;
+	pairs[npairs].b = b->id;
+	pairs[npairs].a_layer = a->layer;
+	pairs[npairs].b_layer = b->layer;
+	return npairs + 1;
+}
+
+static void collision_bucket(struct collision_grid *c)
+{
+	int i, ncells = c->cols * c->rows;
+
+	for(i = 0; i <= ncells; i++) {
+		c->cell_start[i] = 0;
+	}
+
+	for(i = 0; i < c->count; i++) {
+		if(c->shapes[i].cell >= 0) c->cell_start[c->shapes[i].cell]++;
+	}
+
+	/* Inclusive prefix sums, then fill each cell from its end. */
+	for(i = 1; i < ncells; i++) {
+		c->cell_start[i] += c->cell_start[i - 1];
+	}
+	c->cell_start[ncells] = c->cell_start[ncells - 1];
+
+	for(i = 0; i < c->count; i++) {
+		int cell = c->shapes[i].cell;
+		if(cell >= 0) c->order[--c->cell_start[cell]] = i;
+	}
+}
+
+int collision_find_pairs(struct collision_grid *c, struct collision_pair *pairs, int max_pairs)
+{
+	int i, j, k, row, col;
+	int npairs = 0;
+
+	collision_bucket(c);
+
+	for(i = 0; i < c->count && npairs < max_pairs; i++) {
+		struct collision_shape *a = &c->shapes[i];
+		if(!a->mask) continue;
+
+		if(a->cell < 0) {
+			for(j = 0; j < c->count; j++) {
+				npairs = collision_test(c, i, j, pairs, npairs, max_pairs);
+			}
+			continue;
+		}
+
+		int arow = a->cell / c->cols;
+		int acol = a->cell % c->cols;
+
+		for(row = MAX(arow - 1, 0); row <= MIN(arow + 1, c->rows - 1); row++) {
+			for(col = MAX(acol - 1, 0); col <= MIN(acol + 1, c->cols - 1); col++) {
+				int cell = row * c->cols + col;
+				for(k = c->cell_start[cell]; k < c->cell_start[cell + 1]; k++) {
+					npairs = collision_test(c, i, c->order[k], pairs, npairs, max_pairs);
+				}
+			}
+		}
+
+		for(j = 0; j < c->nlarge; j++) {
+			npairs = collision_test(c, i, c->large[j], pairs, npairs, max_pairs);
+		}
+	}
+
+	return npairs;
+}
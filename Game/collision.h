@@ -0,0 +1,38 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+/*
+A collision grid answers "which shapes overlap?" from object
+state alone, without looking at the framebuffer.  Each frame,
+the caller clears the grid, adds a bounding circle or box for
+every live object, and then asks for the overlapping pairs.
+
+Every shape belongs to one layer (a single bit) and carries a mask
+of the layers that it wants to hit.  A pair (a,b) is reported when
+a's mask includes b's layer.  If both shapes want each other, the
+pair is reported once.  The ids given at insertion are returned
+in the pairs, so the caller can map them back to its own objects.
+
+The broad phase is a uniform grid: shapes are bucketed by the
+cell containing their center, and each querying shape only
+examines the 3x3 block of cells around its own.  Shapes wider
+than a cell are kept aside and tested against everything.
+*/
+
+struct collision_pair {
+	int a;
+	int b;
+	unsigned a_layer;
+	unsigned b_layer;
+};
+
+struct collision_grid *collision_grid_create(int width, int height, int cell_size, int capacity);
+void collision_grid_delete(struct collision_grid *c);
+void collision_grid_clear(struct collision_grid *c);
+
+int  collision_add_circle(struct collision_grid *c, int x, int y, int r, unsigned layer, unsigned mask, int id);
+int  collision_add_box(struct collision_grid *c, int x, int y, int w, int h, unsigned layer, unsigned mask, int id);
+
+int  collision_find_pairs(struct collision_grid *c, struct collision_pair *pairs, int max_pairs);
+
+#endif
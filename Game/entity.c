@@ -0,0 +1,112 @@
+#include "entity.h"
+#include "backend.h"
+
+struct entity_pool *entity_pool_create(int capacity)
+{
+	struct entity_pool *p = backend_alloc(sizeof(*p));
+	if(!p) return 0;
+
+	p->capacity = capacity;
+	p->count = 0;
+
+	p->x = backend_alloc(sizeof(int) * capacity);
+	p->y = backend_alloc(sizeof(int) * capacity);
+	p->px = backend_alloc(sizeof(int) * capacity);
+	p->py = backend_alloc(sizeof(int) * capacity);
+	p->vx = backend_alloc(sizeof(int) * capacity);
+	p->vy = backend_alloc(sizeof(int) * capacity);
+	p->phase = backend_alloc(sizeof(int) * capacity);
+	p->timer = backend_alloc(sizeof(int) * capacity);
+	p->dead = backend_alloc(sizeof(unsigned char) * capacity);
+
+	if(!p->x || !p->y || !p->px || !p->py || !p->vx || !p->vy || !p->phase || !p->timer || !p->dead) {
+		entity_pool_delete(p);
+		return 0;
+	}
+
+	return p;
+}
+
+void entity_pool_delete(struct entity_pool *p)
+{
+	if(!p) return;
+	if(p->x) backend_free(p->x);
+	if(p->y) backend_free(p->y);
+	if(p->px) backend_free(p->px);
+	if(p->py) backend_free(p->py);
+	if(p->vx) backend_free(p->vx);
+	if(p->vy) backend_free(p->vy);
+	if(p->phase) backend_free(p->phase);
+	if(p->timer) backend_free(p->timer);
+	if(p->dead) backend_free(p->dead);
+	backend_free(p);
+}
+
+void entity_pool_clear(struct entity_pool *p)
+{
+	p->count = 0;
+}
+
+int entity_spawn(struct entity_pool *p, int x, int y, int vx, int vy, int phase, int timer)
+{
+	if(p->count >= p->capacity) return -1;
+
+	int i = p->count++;
+	p->x[i] = x;
+	p->y[i] = y;
+	p->px[i] = x;
+	p->py[i] = y;
+	p->vx[i] = vx;
+	p->vy[i] = vy;
+	p->phase[i] = phase;
+	p->timer[i] = timer;
+	p->dead[i] = 0;
+	return i;
+}
+
+void entity_kill(struct entity_pool *p, int i)
+{
+	p->dead[i] = 1;
+}
+
+void entity_move(struct entity_pool *p)
+{
+	int i;
+	for(i = 0; i < p->count; i++) {
+		p->px[i] = p->x[i];
+		p->py[i] = p->y[i];
+		p->x[i] += p->vx[i];
+		p->y[i] += p->vy[i];
+	}
+}
+
+/* Mark every entity whose position has left the given box. */
+
+void entity_cull(struct entity_pool *p, int xmin, int ymin, int xmax, int ymax)
+{
+	int i;
+	for(i = 0; i < p->count; i++) {
+		p->dead[i] |= (p->x[i] < xmin) | (p->x[i] > xmax) | (p->y[i] < ymin) | (p->y[i] > ymax);
+	}
+}
+
+void entity_compact(struct entity_pool *p)
+{
+	int i = 0;
+	while(i < p->count) {
+		if(p->dead[i]) {
+			int last = --p->count;
+			p->x[i] = p->x[last];
+			p->y[i] = p->y[last];
+			p->px[i] = p->px[last];
+			p->py[i] = p->py[last];
+			p->vx[i] = p->vx[last];
+			p->vy[i] = p->vy[last];
+			p->phase[i] = p->phase[last];
+			p->timer[i] = p->timer[last];
+			p->dead[i] = p->dead[last];
+		} else {
+			i++;
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef ENTITY_H
+#define ENTITY_H
+
+/*
+An entity pool holds many objects of the same kind as a structure
+of arrays.  Live entities are always packed into [0,count), so
+update loops walk plain integer arrays from start to finish and
+can be written without per-entity branches.
+
+Entities are never removed in the middle of a frame: entity_kill
+(or a loop that sets dead[i]) only marks them, and entity_compact
+later moves the last live entity into each hole.  Indices are
+therefore stable until the next entity_compact.
+
+entity_move remembers where each entity was before the step in
+px and py, so that a renderer running between steps can draw it
+part of the way along its path.
+*/
+
+struct entity_pool {
+	int capacity;
+	int count;
+	int *x;
+	int *y;
+	int *px;
+	int *py;
+	int *vx;
+	int *vy;
+	int *phase;
+	int *timer;
+	unsigned char *dead;
+};
+
+struct entity_pool *entity_pool_create(int capacity);
+void entity_pool_delete(struct entity_pool *p);
+void entity_pool_clear(struct entity_pool *p);
+
+int  entity_spawn(struct entity_pool *p, int x, int y, int vx, int vy, int phase, int timer);
+void entity_kill(struct entity_pool *p, int i);
+
+void entity_move(struct entity_pool *p);
+void entity_cull(struct entity_pool *p, int xmin, int ymin, int xmax, int ymax);
+void entity_compact(struct entity_pool *p);
+
+#endif
@@ -0,0 +1,680 @@
+#include "game.h"
+#include "backend.h"
+
+#define MAX_CATCHUP_TICKS 5 // After a long stall, drop the lost time instead of running more steps than this
+#define MAX_COLLISIONS 64
+
+// Collision layers, each object is in one layer and says which layers it can hit
+#define LAYER_SHIP 1
+#define LAYER_BULLET 2
+#define LAYER_ASTEROID 4
+
+static const int fragment_velocity[][2] = {{-3, -3}, {3, -3}, {-4, 0}, {4, 0}, {-2, 3}, {2, 3}};
+#define FRAGMENT_DIRECTIONS (int)(sizeof(fragment_velocity) / sizeof(fragment_velocity[0]))
+
+void game_config_text(struct game_config *c, int width, int height) // Geometry of the two text mode targets, in characters
+{
+	c->width = width;
+	c->height = height;
+	c->text_width = 1;
+	c->text_height = 1;
+	c->line_height = 1;
+	c->margin = 0;
+	c->tick_millis = 35;
+	c->interpolate = 0;
+
+	c->ship_width = 5; // "/-^-\"
+	c->ship_height = 1;
+	c->ship_bottom = 1;
+	c->ship_step = 1;
+
+	c->bullet_width = 1;
+	c->bullet_height = 1;
+	c->bullet_x = 2;
+	c->bullet_y = 0;
+	c->bullet_speed = 1;
+	c->bullet_top = 1;
+	c->max_bullets = 1; // A new bullet can't be fired until the last one hits something
+	c->fire_cooldown = 0;
+
+	const int asteroid_width[ASTEROID_PHASES] = {8, 6, 3, 2};
+	const int asteroid_height[ASTEROID_PHASES] = {4, 3, 2, 1};
+	for (int i = 0; i < ASTEROID_PHASES; i++)
+	{
+		c->asteroid_width[i] = asteroid_width[i];
+		c->asteroid_height[i] = asteroid_height[i];
+	}
+	c->round_asteroids = 0;
+	c->asteroid_step = 1;
+	c->asteroid_move_ticks = 15;
+	c->asteroid_spawn_ticks = 90;
+	c->asteroid_spawn_y = 3;
+	c->asteroid_spawn_xmin = 5;
+	c->asteroid_spawn_xmax = width - 5;
+	c->explode_ticks = 15; // Until the next move
+	c->ground = height - 4;
+	c->max_asteroids = 3;
+	c->stress_asteroids = 0;
+
+	c->fragment_size = 1;
+	c->fragment_ticks = 0;
+	c->fragments_per_hit = 0;
+	c->max_fragments = 0;
+}
+
+void game_config_graphics(struct game_config *c, int width, int height) // Geometry of the two graphical targets, in pixels
+{
+	c->width = width;
+	c->height = height;
+	c->text_width = 8;
+	c->text_height = 8;
+	c->line_height = 10;
+	c->margin = 8;
+	c->tick_millis = 50;
+	c->interpolate = 1;
+
+	c->ship_width = 71;
+	c->ship_height = 30;
+	c->ship_bottom = 0;
+	c->ship_step = 5;
+
+	c->bullet_width = 3;
+	c->bullet_height = 10;
+	c->bullet_x = 34; // From the nose of the ship
+	c->bullet_y = 10;
+	c->bullet_speed = 20;
+	c->bullet_top = 10;
+	c->max_bullets = 64;
+	c->fire_cooldown = 5;
+
+	const int asteroid_radius[ASTEROID_PHASES] = {55, 40, 25, 15};
+	for (int i = 0; i < ASTEROID_PHASES; i++)
+	{
+		c->asteroid_width[i] = 2 * asteroid_radius[i];
+		c->asteroid_height[i] = 2 * asteroid_radius[i];
+	}
+	c->round_asteroids = 1;
+	c->asteroid_step = 1;
+	c->asteroid_move_ticks = 1;
+	c->asteroid_spawn_ticks = 120;
+	c->asteroid_spawn_y = 70;
+	c->asteroid_spawn_xmin = 100;
+	c->asteroid_spawn_xmax = width - 130;
+	c->explode_ticks = 10;
+	c->ground = height - 55;
+	c->max_asteroids = 3;
+	c->stress_asteroids = 0;
+
+	c->fragment_size = 3;
+	c->fragment_ticks = 8;
+	c->fragments_per_hit = 6;
+	c->max_fragments = 256;
+}
+
+struct game *game_create(const struct game_config *config, unsigned seed)
+{
+	struct game *g = backend_alloc(sizeof(*g));
+	if (!g)
+		return 0;
+
+	g->config = *config;
+	g->seed = seed;
+	g->show_hud = (config->stress_asteroids > 0);
+
+	int asteroids = config->max_asteroids > config->stress_asteroids ? config->max_asteroids : config->stress_asteroids;
+	int cell_size = (config->asteroid_width[0] > config->asteroid_height[0] ? config->asteroid_width[0] : config->asteroid_height[0]) + 2;
+
+	g->bullets = entity_pool_create(config->max_bullets);
+	g->asteroids = entity_pool_create(asteroids);
+	g->fragments = entity_pool_create(config->max_fragments > 0 ? config->max_fragments : 1);
+	g->collision_grid = collision_grid_create(config->width, config->height, cell_size, config->max_bullets + asteroids + 1);
+
+	if (!g->bullets || !g->asteroids || !g->fragments || !g->collision_grid)
+	{
+		game_delete(g);
+		return 0;
+	}
+
+	game_reset(g);
+	return g;
+}
+
+void game_delete(struct game *g)
+{
+	if (!g)
+		return;
+	entity_pool_delete(g->bullets);
+	entity_pool_delete(g->asteroids);
+	entity_pool_delete(g->fragments);
+	collision_grid_delete(g->collision_grid);
+	backend_free(g);
+}
+
+void game_reset(struct game *g) // Function that places the ship in the bottom middle and resets all game variables
+{
+	struct game_config *c = &g->config;
+
+	g->ship_x = (c->width - c->ship_width) / 2; // pos = middle bottom
+	g->ship_y = c->height - c->ship_height - c->ship_bottom;
+	entity_pool_clear(g->bullets); // Clear all objects so they can be (re)spawn
+	entity_pool_clear(g->asteroids);
+	entity_pool_clear(g->fragments);
+
+	g->key_count = 0;
+	g->step = 0;
+	g->fire_cooldown = 0;
+	g->life = 3;
+	g->score = 0;
+	g->over = 0;
+	g->restart = 0;
+	g->pause = 0;
+	g->quit = 0;
+	g->alpha = ALPHA_ONE;
+}
+
+int game_rand(struct game *g, int start, int end) // Function that generate a pseudo-random integer, the same sequence on every target
+{
+	g->seed = g->seed * 1103515245 + 12345;
+	return (g->seed / 65536) % (end - start) + start;
+}
+
+void game_key(struct game *g, int key) // The key is handled in the next step, together with any others pressed before it
+{
+	if (g->key_count < GAME_KEY_QUEUE)
+		g->keys[g->key_count++] = key;
+}
+
+static void fire_bullet(struct game *g) // Function that fires a bullet from the nose of the space_ship
+{
+	struct game_config *c = &g->config;
+
+	if (g->fire_cooldown == 0 && entity_spawn(g->bullets, g->ship_x + c->bullet_x, g->ship_y + c->bullet_y, 0, -c->bullet_speed, 0, 0) >= 0)
+		g->fire_cooldown = c->fire_cooldown;
+}
+
+static void move_and_fire_space_ship(struct game *g) // Function that takes keyboard inputs and determines the movements of the spaceship and the starting point of the bullet according to these inputs
+{
+	struct game_config *c = &g->config;
+	int left = 0, right = 0, fire = 0;
+
+	for (int i = 0; i < g->key_count; i++) // Every key pressed since the last step
+	{
+		switch (g->keys[i])
+		{
+		case 'a':
+			left++;
+			break;
+		case 'd':
+			right++;
+			break;
+		case ' ':
+			fire = 1;
+			break;
+		case 'r':
+			g->restart = 1;
+			break;
+		case 'p':
+			g->pause = 1;
+			break;
+		case 'h':
+			g->show_hud = !g->show_hud;
+			backend_erase(c->margin, c->margin + 2 * c->line_height, c->width - c->margin, c->text_height);
+			break;
+		}
+	}
+	g->key_count = 0; // After the keys are processed, they are cleared so that they do not enter the same place again.
+
+	// A key that is held down acts on every step, on the backends that can tell
+	if (!left && backend_key_held('a'))
+		left = 1;
+	if (!right && backend_key_held('d'))
+		right = 1;
+	if (backend_key_held(' '))
+		fire = 1;
+
+	for (; left > 0 && g->ship_x > c->ship_step; left--)
+		g->ship_x -= c->ship_step;
+	for (; right > 0 && g->ship_x < c->width - c->ship_width - c->ship_step; right--)
+		g->ship_x += c->ship_step;
+
+	if (fire || c->stress_asteroids) // In stress mode the ship keeps firing on its own
+		fire_bullet(g);
+	g->fire_cooldown -= (g->fire_cooldown > 0);
+}
+
+static void spawn_asteroids(struct game *g) // Function that spawns asteroids from a random x location
+{
+	struct game_config *c = &g->config;
+
+	if (g->step % c->asteroid_spawn_ticks == 0 && g->asteroids->count < c->max_asteroids)
+		entity_spawn(g->asteroids, game_rand(g, c->asteroid_spawn_xmin, c->asteroid_spawn_xmax), c->asteroid_spawn_y, 0, c->asteroid_step, 0, 0);
+
+	while (g->asteroids->count < c->stress_asteroids) // Fill the screen with asteroids of every size but the largest
+		entity_spawn(g->asteroids, game_rand(g, c->asteroid_spawn_xmin, c->asteroid_spawn_xmax), game_rand(g, c->asteroid_spawn_y, c->ground), 0, c->asteroid_step * game_rand(g, 1, 4), game_rand(g, 1, ASTEROID_PHASES), 0);
+}
+
+static void move_asteroids(struct game *g)
+{
+	struct game_config *c = &g->config;
+	struct entity_pool *a = g->asteroids;
+	int lost = 0;
+	int wrap = c->stress_asteroids ? c->ground - c->asteroid_spawn_y : 0; // In stress mode a landed asteroid wraps back to the top
+	int kill = !c->stress_asteroids; // Otherwise it costs a life and is deactivated
+
+	if (g->step % c->asteroid_move_ticks == 0)
+		entity_move(a);
+	else
+		for (int i = 0; i < a->count; i++) // Standing still this step
+		{
+			a->px[i] = a->x[i];
+			a->py[i] = a->y[i];
+		}
+
+	for (int i = 0; i < a->count; i++) // Written without branches, every asteroid goes through the same steps
+	{
+		int shrink = (a->timer[i] == 1); // Explosion ends this step, reduce the size
+		a->timer[i] -= (a->timer[i] > 0);
+		a->phase[i] += shrink; // increasing phase means decreasing size
+		a->dead[i] |= (a->phase[i] >= ASTEROID_PHASES); // If it was the smallest, deactivate it
+
+		int landed = (a->y[i] > c->ground) & !a->dead[i]; // It reached the bottom of the screen, below the spaceship
+		a->y[i] -= landed * wrap;
+		a->py[i] -= landed * wrap;
+		a->dead[i] |= landed & kill;
+		lost += landed & kill;
+	}
+	g->life -= lost;
+}
+
+static void move_fragments(struct game *g)
+{
+	struct entity_pool *f = g->fragments;
+
+	entity_move(f);
+	for (int i = 0; i < f->count; i++)
+	{
+		f->timer[i]--;
+		f->dead[i] |= (f->timer[i] <= 0);
+	}
+	entity_cull(f, 0, 0, g->config.width - g->config.fragment_size, g->config.height - g->config.fragment_size);
+}
+
+static void explode_asteroid(struct game *g, int id) // Function that starts the explosion of an asteroid and throws fragments out of it
+{
+	struct game_config *c = &g->config;
+	struct entity_pool *a = g->asteroids;
+
+	a->timer[id] = c->explode_ticks;
+	for (int i = 0; i < c->fragments_per_hit; i++)
+		entity_spawn(g->fragments, a->x[id], a->y[id], fragment_velocity[i % FRAGMENT_DIRECTIONS][0], fragment_velocity[i % FRAGMENT_DIRECTIONS][1], 0, c->fragment_ticks);
+}
+
+static void collision_event(struct game *g) // Function that handles collisions and life checking
+{
+	struct game_config *c = &g->config;
+	struct entity_pool *b = g->bullets;
+	struct entity_pool *a = g->asteroids;
+	struct collision_pair pairs[MAX_COLLISIONS];
+
+	// Describe every live object by its bounding shape, the grid finds the overlapping pairs
+	collision_grid_clear(g->collision_grid);
+	collision_add_box(g->collision_grid, g->ship_x, g->ship_y, c->ship_width, c->ship_height, LAYER_SHIP, LAYER_ASTEROID, 0);
+	for (int i = 0; i < b->count; i++) // The box covers the whole distance travelled this step, so a fast bullet can't skip over a small asteroid
+		if (!b->dead[i])
+			collision_add_box(g->collision_grid, b->x[i], b->y[i], c->bullet_width, c->bullet_height + c->bullet_speed, LAYER_BULLET, LAYER_ASTEROID, i);
+	for (int i = 0; i < a->count; i++)
+	{
+		if (a->dead[i])
+			continue;
+		int w = c->asteroid_width[a->phase[i]];
+		int h = c->asteroid_height[a->phase[i]];
+		if (c->round_asteroids)
+			collision_add_circle(g->collision_grid, a->x[i], a->y[i], w / 2, LAYER_ASTEROID, 0, i);
+		else
+			collision_add_box(g->collision_grid, a->x[i] - w / 2, a->y[i] - h / 2, w, h, LAYER_ASTEROID, 0, i);
+	}
+
+	int n = collision_find_pairs(g->collision_grid, pairs, MAX_COLLISIONS);
+	for (int i = 0; i < n; i++)
+	{
+		int id = pairs[i].b;
+		if (a->dead[id])
+			continue;
+		if (pairs[i].a_layer == LAYER_BULLET && !b->dead[pairs[i].a]) // Bullet hit, the bullet is used up and a whole asteroid explodes
+		{
+			entity_kill(b, pairs[i].a);
+			if (!a->timer[id])
+			{
+				explode_asteroid(g, id);
+				g->score++;
+			}
+		}
+		else if (pairs[i].a_layer == LAYER_SHIP && !c->stress_asteroids) // Asteroid hit the space ship, lose life and deactivate.
+		{
+			entity_kill(a, id);
+			g->life--;
+		}
+	}
+	if (g->life <= 0)
+		g->over = 1;
+}
+
+void game_step(struct game *g) // Function that advances the game by one fixed step
+{
+	move_and_fire_space_ship(g);
+	entity_move(g->bullets); // Bullets that reach the top are deactivated so they can be fired again
+	entity_cull(g->bullets, 0, g->config.bullet_top, g->config.width, g->config.height);
+	spawn_asteroids(g);
+	move_asteroids(g);
+	move_fragments(g);
+	collision_event(g);
+
+	// Dead objects are removed only after everyone had a chance to see them this step
+	entity_compact(g->bullets);
+	entity_compact(g->asteroids);
+	entity_compact(g->fragments);
+	g->step++;
+}
+
+static int interpolate(struct game *g, int from, int to) // Function that returns the position to draw between two steps
+{
+	return from + (to - from) * g->alpha / ALPHA_ONE;
+}
+
+static void asteroid_box(struct game *g, int i, int *x, int *y, int *w, int *h) // Function that returns the area covered by an asteroid
+{
+	struct game_config *c = &g->config;
+	struct entity_pool *a = g->asteroids;
+
+	*w = c->asteroid_width[a->phase[i]];
+	*h = c->asteroid_height[a->phase[i]];
+	*x = interpolate(g, a->px[i], a->x[i]) - *w / 2;
+	*y = interpolate(g, a->py[i], a->y[i]) - *h / 2;
+	if (c->round_asteroids) // A circle covers one more pixel than its diameter
+	{
+		(*w)++;
+		(*h)++;
+	}
+}
+
+static void game_paint(struct game *g, int draw) // Function that draws or deletes every game object
+{
+	struct game_config *c = &g->config;
+	struct entity_pool *b = g->bullets;
+	struct entity_pool *a = g->asteroids;
+	struct entity_pool *f = g->fragments;
+	int x, y, w, h;
+
+	if (draw)
+		backend_draw_ship(g->ship_x, g->ship_y, c->ship_width, c->ship_height);
+	else
+		backend_erase(g->ship_x, g->ship_y, c->ship_width, c->ship_height);
+
+	for (int i = 0; i < b->count; i++)
+	{
+		x = interpolate(g, b->px[i], b->x[i]);
+		y = interpolate(g, b->py[i], b->y[i]);
+		if (draw)
+			backend_draw_bullet(x, y, c->bullet_width, c->bullet_height);
+		else
+			backend_erase(x, y, c->bullet_width, c->bullet_height);
+	}
+
+	for (int i = 0; i < a->count; i++)
+	{
+		asteroid_box(g, i, &x, &y, &w, &h);
+		if (draw)
+			backend_draw_asteroid(x, y, w, h, a->phase[i], a->timer[i] > 0);
+		else
+			backend_erase(x, y, w, h);
+	}
+
+	for (int i = 0; i < f->count; i++)
+	{
+		x = interpolate(g, f->px[i], f->x[i]);
+		y = interpolate(g, f->py[i], f->y[i]);
+		if (draw)
+			backend_draw_fragment(x, y, c->fragment_size, c->fragment_size, f->timer[i] > c->fragment_ticks / 2 ? YELLOW : RED);
+		else
+			backend_erase(x, y, c->fragment_size, c->fragment_size);
+	}
+}
+
+void game_draw(struct game *g, int alpha) // Moving objects are drawn part of the way between their previous and current step
+{
+	g->alpha = alpha;
+	game_paint(g, 1);
+}
+
+void game_erase(struct game *g) // Deletes every object where the last game_draw put it
+{
+	game_paint(g, 0);
+}
+
+static int string_length(const char *str)
+{
+	int n = 0;
+	while (str[n])
+		n++;
+	return n;
+}
+
+static char *append(char *dst, const char *src) // Copies src to dst and returns the end of dst
+{
+	while (*src)
+		*dst++ = *src++;
+	*dst = 0;
+	return dst;
+}
+
+static char *append_number(char *dst, unsigned n)
+{
+	char digits[12];
+	int i = 0;
+	do
+	{
+		digits[i++] = n % 10 + '0';
+		n /= 10;
+	} while (n);
+	while (i > 0)
+		*dst++ = digits[--i];
+	*dst = 0;
+	return dst;
+}
+
+static void print_text(struct game *g, int x, int y, const char *str, int color) // Writes over whatever was there before
+{
+	backend_erase(x, y, string_length(str) * g->config.text_width, g->config.text_height);
+	backend_print(x, y, str, color);
+}
+
+static void print_score(struct game *g, int x, int y) // Function that writes the score, always as 3 digits
+{
+	char score[4];
+	int temp = g->score;
+	for (int i = 2; i > -1; i--)
+	{
+		score[i] = temp % 10 + '0';
+		temp /= 10;
+	}
+	score[3] = 0;
+	print_text(g, x, y, "Score:", LIGHT_CYAN);
+	print_text(g, x + 6 * g->config.text_width, y, score, WHITE);
+}
+
+static void print_status(struct game *g) // Function that writes the life in the upper left and the score in the upper right corner of the screen
+{
+	struct game_config *c = &g->config;
+	char life[2] = {(char)(g->life > 0 ? g->life : 0) + '0', '\0'};
+
+	print_text(g, c->margin, c->margin, "Life:", LIGHT_GREEN);
+	print_text(g, c->margin + 5 * c->text_width, c->margin, life, WHITE);
+	print_score(g, c->width - c->margin - 9 * c->text_width, c->margin);
+}
+
+static void print_hud(struct game *g, int fps, unsigned update_time, unsigned draw_time, unsigned present_time) // Function that reports where the time of the last frame went
+{
+	struct game_config *c = &g->config;
+	char line[128];
+	char *p = line;
+
+	p = append(p, "fps: ");
+	p = append_number(p, fps);
+	p = append(p, " update us: ");
+	p = append_number(p, backend_timer_usec(update_time));
+	p = append(p, " draw us: ");
+	p = append_number(p, backend_timer_usec(draw_time));
+	p = append(p, " present us: ");
+	p = append_number(p, backend_timer_usec(present_time));
+	p = append(p, " objects: ");
+	p = append_number(p, g->bullets->count + g->asteroids->count + g->fragments->count);
+	p = append(p, "    ");
+	print_text(g, c->margin, c->margin + 2 * c->line_height, line, YELLOW);
+}
+
+static void print_message(struct game *g, int line, const char *str, int color) // Writes a line centered on the screen
+{
+	struct game_config *c = &g->config;
+	print_text(g, (c->width - string_length(str) * c->text_width) / 2, c->height / 2 + line * c->line_height, str, color);
+}
+
+static int wait_for_enter(struct game *g)
+{
+	while (1)
+	{
+		int key = backend_read_key();
+		if (key == GAME_KEY_QUIT)
+		{
+			g->quit = 1;
+			return 0;
+		}
+		if (key == '\r' || key == '\n')
+			return 1;
+		if (!key)
+			backend_wait(GAME_WAIT_KEY); // Nothing to draw until then
+	}
+}
+
+static void game_play(struct game *g) // Runs the game until it is over, restarted, paused or quit
+{
+	struct game_config *c = &g->config;
+	unsigned last = backend_millis(); // Time spent in the menus doesn't count as game time
+	unsigned lag = 0;				  // Time not yet simulated
+	unsigned fps_start = last;
+	int frames = 0;
+	int fps = 0;
+	unsigned present_time = 0;
+
+	backend_clear();
+	g->alpha = ALPHA_ONE;
+	while (1)
+	{
+		int key;
+		while ((key = backend_read_key()) != 0) // Take every key that is waiting, not only one per frame
+		{
+			if (key == GAME_KEY_QUIT)
+			{
+				g->quit = 1;
+				return;
+			}
+			game_key(g, key);
+		}
+		if (g->over || g->restart || g->pause)
+			return;
+
+		unsigned now = backend_millis();
+		lag += now - last;
+		last = now;
+		if (lag > MAX_CATCHUP_TICKS * c->tick_millis)
+			lag = MAX_CATCHUP_TICKS * c->tick_millis;
+
+		if (!c->interpolate && lag < c->tick_millis) // Nothing moves before the next step
+		{
+			backend_wait(c->tick_millis - lag);
+			continue;
+		}
+
+		unsigned frame_start = backend_timer();
+
+		// Clear, at the same place the last frame was drawn
+		game_erase(g);
+
+		unsigned erase_end = backend_timer();
+
+		// Move and do Events, as many steps as the time that has passed
+		while (lag >= c->tick_millis && !g->over && !g->restart && !g->pause)
+		{
+			game_step(g);
+			lag -= c->tick_millis;
+		}
+
+		unsigned update_end = backend_timer();
+
+		// Print
+		game_draw(g, c->interpolate ? lag * ALPHA_ONE / c->tick_millis : ALPHA_ONE);
+		print_status(g);
+		if (g->show_hud)
+			print_hud(g, fps, update_end - erase_end, (erase_end - frame_start) + (backend_timer() - update_end), present_time);
+
+		unsigned present_start = backend_timer();
+		backend_present();
+		present_time = backend_timer() - present_start;
+
+		frames++;
+		if (now - fps_start >= 1000)
+		{
+			fps = frames;
+			frames = 0;
+			fps_start = now;
+		}
+
+		if (c->interpolate)
+			backend_wait(1); // Draw again on the next clock tick, or sooner if a key is pressed
+	}
+}
+
+static void print_author(struct game *g)
+{
+	struct game_config *c = &g->config;
+	print_text(g, (c->width - 33 * c->text_width) / 2, c->margin + c->line_height, "180101012 - Ibrahim Yusuf Cosgun", DARK_GRAY);
+}
+
+void game_run(struct game *g) // The whole game: menus, play, restart and pause, until the backend asks to quit
+{
+	struct game_config *c = &g->config;
+
+	game_reset(g);
+	backend_clear();
+	print_message(g, 0, "Start Game", LIGHT_GRAY); // Appears only on first startup
+	print_author(g);
+
+	while (1)
+	{
+		print_message(g, 1, "Press [Enter]", DARK_GRAY); // Appears always
+		backend_present();
+		if (!wait_for_enter(g))
+			return;
+
+		game_play(g);
+		if (g->quit)
+			return;
+
+		if (g->pause) // Pause by just freezing the screen without resetting game objects
+		{
+			g->pause = 0;
+			print_message(g, 0, "Continue Game", LIGHT_GRAY);
+			continue;
+		}
+
+		int score = g->score;
+		int over = g->over;
+		game_reset(g); // Proper reset in case of gameover or restart of the game
+		backend_clear();
+
+		g->score = score; // Appears on every restart and gameover
+		print_score(g, (c->width - 9 * c->text_width) / 2, c->height / 2 - c->line_height);
+		g->score = 0;
+		print_message(g, 0, over ? "Game Over" : "Restart Game", LIGHT_GRAY);
+		print_author(g);
+	}
+}
@@ -0,0 +1,133 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "entity.h"
+#include "collision.h"
+
+/*
+The space shooter itself, shared by every target. The core keeps
+the game state, advances it in fixed steps, and runs the menus and
+the main loop. All drawing, input and timing goes through the
+functions in backend.h.
+
+Positions and sizes are integers in the target's own units, so the
+same code runs on an 80x25 text screen and a 1024x768 framebuffer.
+A target only has to describe its geometry in a struct game_config.
+The core doesn't use the C library, so it builds inside the kernels.
+*/
+
+// These definitions were used to call a color by its name, each backend maps them to its own colors.
+#define BLACK 0
+#define BLUE 1
+#define GREEN 2
+#define CYAN 3
+#define RED 4
+#define MAGENTA 5
+#define BROWN 6
+#define LIGHT_GRAY 7
+#define DARK_GRAY 8
+#define LIGHT_BLUE 9
+#define LIGHT_GREEN 10
+#define LIGHT_CYAN 11
+#define LIGHT_RED 12
+#define LIGHT_MAGENTA 13
+#define YELLOW 14
+#define WHITE 15
+
+#define GAME_KEY_QUIT -1 // Returned by backend_read_key when the window is closed or the input has ended
+
+#define GAME_WAIT_KEY -1 // Given to backend_wait when nothing happens until a key is pressed
+#define GAME_KEY_QUEUE 16 // Keys pressed faster than this many per step are dropped
+
+#define ASTEROID_PHASES 4
+#define ALPHA_ONE 256 // Interpolation goes from 0 (previous step) to ALPHA_ONE (current step)
+
+struct game_config
+{
+	int width; // Size of the screen
+	int height;
+	int text_width; // Size of one character
+	int text_height;
+	int line_height; // Distance between two lines of text
+	int margin;		 // Distance of the score and life from the edges
+	int tick_millis; // Length of one game step
+	int interpolate; // Draw as often as possible, between two steps
+
+	int ship_width;
+	int ship_height;
+	int ship_bottom; // Distance between the ship and the bottom of the screen
+	int ship_step;	 // Distance moved on each key press
+
+	int bullet_width;
+	int bullet_height;
+	int bullet_x; // Where the bullet starts, relative to the ship
+	int bullet_y;
+	int bullet_speed;
+	int bullet_top; // Bullets above this line disappear
+	int max_bullets;
+	int fire_cooldown; // Steps between two shots
+
+	int asteroid_width[ASTEROID_PHASES]; // Size of the asteroid in each phase
+	int asteroid_height[ASTEROID_PHASES];
+	int round_asteroids; // Collide as circles of diameter asteroid_width instead of boxes
+	int asteroid_step;	 // Distance moved every asteroid_move_ticks steps
+	int asteroid_move_ticks;
+	int asteroid_spawn_ticks;
+	int asteroid_spawn_y;
+	int asteroid_spawn_xmin; // Range of the center of a new asteroid
+	int asteroid_spawn_xmax;
+	int explode_ticks; // Steps an asteroid stays exploded before it shrinks
+	int ground;		   // Asteroids whose center passes this line cost a life
+	int max_asteroids;
+	int stress_asteroids; // If not zero, keep this many asteroids on screen to measure performance
+
+	int fragment_size;
+	int fragment_ticks;
+	int fragments_per_hit; // Zero disables the fragments
+	int max_fragments;
+};
+
+struct game
+{
+	struct game_config config;
+
+	int ship_x;
+	int ship_y;
+	struct entity_pool *bullets;
+	struct entity_pool *asteroids; // phase: size of the asteroid, timer: steps left of the explosion
+	struct entity_pool *fragments; // timer: steps left to live
+	struct collision_grid *collision_grid;
+
+	int keys[GAME_KEY_QUEUE]; // Keys to be handled in the next step
+	int key_count;
+	int step;	  // Steps since the game was reset
+	int fire_cooldown;
+	int life;
+	int score;
+	int over;	  // Set by game_step when the game has ended or the player asked for a restart or pause
+	int restart;
+	int pause;
+	int quit;
+
+	int alpha;	  // Interpolation used by the last game_draw, game_erase uses the same
+	int show_hud; // Toggled with 'h'
+	unsigned seed;
+};
+
+void game_config_text(struct game_config *c, int width, int height);
+void game_config_graphics(struct game_config *c, int width, int height);
+
+struct game *game_create(const struct game_config *config, unsigned seed);
+void game_delete(struct game *g);
+void game_reset(struct game *g);
+
+int game_rand(struct game *g, int start, int end);
+
+void game_key(struct game *g, int key);
+void game_step(struct game *g);
+void game_draw(struct game *g, int alpha);
+void game_erase(struct game *g);
+
+void game_run(struct game *g);
+
+#endif
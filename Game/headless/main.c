@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "game.h"
+#include "backend.h"
+
+/*
+Headless backend: runs the shared game core on the host as fast as
+it can, with no screen and no keyboard. Keys come from a recorded
+input script, so every run of the same script and seed plays the
+same game, and the result is a throughput benchmark in steps (ticks)
+per second.
+
+Usage: headless [-m text|graphics] [-n ticks] [-s stress] [-d] [-seed n] [script]
+
+Each line of the script is "<tick> <key> [<count> <every>]": the key
+is pressed at that tick, and again count - 1 more times every
+<every> ticks. A key is a single character, "space" or "enter".
+Empty lines and lines starting with '#' are ignored. When the script
+runs out it starts over, so any number of ticks can be run.
+*/
+
+#define DEFAULT_TICKS 1000000
+#define DEFAULT_SEED 1
+
+struct input_event
+{
+	int tick;
+	int key;
+};
+
+struct input_event *events = NULL;
+int event_count = 0;
+int script_length = 0; // Ticks before the script starts over
+unsigned long draw_calls = 0;
+
+void *backend_alloc(unsigned size)
+{
+	return malloc(size);
+}
+
+void backend_free(void *ptr)
+{
+	free(ptr);
+}
+
+// Nothing is drawn, the calls are only counted so drawing can be included in the benchmark
+void backend_clear(void) { draw_calls++; }
+void backend_erase(int x, int y, int w, int h) { draw_calls++; }
+void backend_print(int x, int y, const char *str, int color) { draw_calls++; }
+void backend_draw_ship(int x, int y, int w, int h) { draw_calls++; }
+void backend_draw_bullet(int x, int y, int w, int h) { draw_calls++; }
+void backend_draw_asteroid(int x, int y, int w, int h, int phase, int exploding) { draw_calls++; }
+void backend_draw_fragment(int x, int y, int w, int h, int color) { draw_calls++; }
+void backend_present(void) {}
+
+// The benchmark drives game_step itself, game_run is never called
+int backend_read_key(void) { return 0; }
+int backend_key_held(int key) { return 0; } // Scripts only press keys
+unsigned backend_millis(void) { return 0; }
+void backend_wait(int millis) {}
+unsigned backend_timer(void) { return 0; }
+unsigned backend_timer_usec(unsigned ticks) { return ticks; }
+
+int compare_events(const void *a, const void *b)
+{
+	return ((const struct input_event *)a)->tick - ((const struct input_event *)b)->tick;
+}
+
+void add_event(int tick, int key)
+{
+	events = realloc(events, (event_count + 1) * sizeof(*events));
+	if (!events)
+	{
+		fprintf(stderr, "headless: out of memory\n");
+		exit(1);
+	}
+	events[event_count].tick = tick;
+	events[event_count].key = key;
+	event_count++;
+	if (tick >= script_length)
+		script_length = tick + 1;
+}
+
+void load_script(const char *path) // Function that reads the input script into a list of events sorted by tick
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		fprintf(stderr, "headless: couldn't open %s\n", path);
+		exit(1);
+	}
+
+	char line[256];
+	int line_number = 0;
+	while (fgets(line, sizeof(line), file))
+	{
+		char name[32];
+		int tick, count = 1, every = 1, key;
+
+		line_number++;
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		int fields = sscanf(line, "%d %31s %d %d", &tick, name, &count, &every);
+		if (fields < 2 || fields == 3 || tick < 0 || count < 1 || every < 1)
+		{
+			fprintf(stderr, "headless: %s:%d: expected \"<tick> <key> [<count> <every>]\"\n", path, line_number);
+			exit(1);
+		}
+
+		if (!strcmp(name, "space"))
+			key = ' ';
+		else if (!strcmp(name, "enter"))
+			key = '\r';
+		else if (strlen(name) == 1)
+			key = name[0];
+		else
+		{
+			fprintf(stderr, "headless: %s:%d: unknown key %s\n", path, line_number, name);
+			exit(1);
+		}
+
+		for (int i = 0; i < count; i++)
+			add_event(tick + i * every, key);
+	}
+	fclose(file);
+
+	qsort(events, event_count, sizeof(*events), compare_events);
+}
+
+double seconds_now()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void usage()
+{
+	fprintf(stderr, "usage: headless [-m text|graphics] [-n ticks] [-s stress] [-d] [-seed n] [script]\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	struct game_config config;
+	const char *mode = "graphics";
+	const char *script = NULL;
+	long ticks = DEFAULT_TICKS;
+	int stress = 0;
+	int draw = 0;
+	unsigned seed = DEFAULT_SEED;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-m") && i + 1 < argc)
+			mode = argv[++i];
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			ticks = atol(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			stress = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-d"))
+			draw = 1;
+		else if (!strcmp(argv[i], "-seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], NULL, 0);
+		else if (argv[i][0] != '-' && !script)
+			script = argv[i];
+		else
+			usage();
+	}
+
+	if (!strcmp(mode, "text"))
+		game_config_text(&config, 80, 25); // mkeykernel and termios
+	else if (!strcmp(mode, "graphics"))
+		game_config_graphics(&config, 1024, 768); // basekernel and SDL
+	else
+		usage();
+	config.stress_asteroids = stress;
+
+	if (script)
+		load_script(script);
+
+	struct game *g = game_create(&config, seed);
+	if (!g)
+	{
+		fprintf(stderr, "headless: out of memory\n");
+		return 1;
+	}
+
+	long games = 0;
+	long total_score = 0;
+	int next_event = 0;
+	long script_start = 0;
+
+	double start = seconds_now();
+	for (long tick = 0; tick < ticks; tick++)
+	{
+		if (event_count)
+		{
+			if (next_event == event_count) // Start the script over
+			{
+				next_event = 0;
+				script_start = tick;
+			}
+			while (next_event < event_count && script_start + events[next_event].tick == tick)
+				game_key(g, events[next_event++].key);
+		}
+
+		if (draw)
+			game_erase(g);
+		game_step(g);
+		if (draw)
+			game_draw(g, ALPHA_ONE);
+
+		if (g->over || g->restart)
+		{
+			games += g->over;
+			total_score += g->score;
+			game_reset(g);
+		}
+		g->pause = 0; // Nobody to press Enter
+	}
+	double elapsed = seconds_now() - start;
+	total_score += g->score;
+
+	printf("mode: %s %dx%d, stress: %d, drawing: %s, seed: %u, script: %s\n", mode, config.width, config.height, stress, draw ? "on" : "off", seed, script ? script : "none");
+	printf("ticks: %ld in %.3f s, %.0f ticks/s\n", ticks, elapsed, elapsed > 0 ? ticks / elapsed : 0);
+	printf("games over: %ld, total score: %ld, draw calls: %lu\n", games, total_score, draw_calls);
+
+	game_delete(g);
+	free(events);
+	return 0;
+}
@@ -1,19 +1,19 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
-#include <math.h>
+#include <string.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include "game.h"
+#include "backend.h"
 
 #define WINDOW_WIDTH 1024
 #define WINDOW_HEIGHT 768
 SDL_Window *window = NULL;
 SDL_Renderer *renderer = NULL;
-SDL_Surface *getPixel_Surface;
-Uint8 getPixel_bpp;
 TTF_Font *font = NULL;
 SDL_Event event;
-int quit;
 
 SDL_Color color_array[16] = {
 	{0, 0, 0, 255},
@@ -33,584 +33,491 @@ SDL_Color color_array[16] = {
 	{0xFF, 0xFF, 0, 255},
 	{0xFF, 0xFF, 0xFF, 255}};
 
-#define BLACK 0
-#define BLUE 1
-#define GREEN 2
-#define CYAN 3
-#define RED 4
-#define MAGENTA 5
-#define BROWN 6
-#define LIGHT_GRAY 7
-#define DARK_GRAY 8
-#define LIGHT_BLUE 9
-#define LIGHT_GREEN 10
-#define LIGHT_CYAN 11
-#define LIGHT_RED 12
-#define LIGHT_MAGENTA 13
-#define YELLOW 14
-#define WHITE 15
-
-typedef enum
-{
-	false,
-	true
-} bool; // define bool as enum to increase readability
-
-#define TEXT_PIXEL_WIDTH 8
-#define TEXT_PIXEL_HEIGHT 7
-
-struct Space_Ship
-{
-	int x;
-	int y;
-};
-
-struct Bullet
-{
-	bool active;
-	int x;
-	int y;
-};
-
-#define NUMBER_OF_ASTEROIDS 3
-struct Asteroid
-{
-	bool active;
-	int x;
-	int y;
-	bool explode;
-	int phase;
-};
-struct Space_Ship space_ship;
-struct Bullet bullet;
-struct Asteroid asteroids[NUMBER_OF_ASTEROIDS];
-
-char current_key = 0;
-bool key_pressed = false;
-bool game_start = false;
-bool game_over = false;
-bool game_restart = false;
-bool game_pause = false;
-int life = 3;
-int score = 0;
-char Score[3];
-
+/*
+In software mode (the default) everything is drawn by the CPU into
+framebuffer, one ARGB8888 pixel per Uint32, and each frame the rows
+that changed are copied into a streaming texture with SDL_LockTexture
+and shown with a single SDL_RenderCopy. Start with -r to draw through
+the renderer instead, one SDL_RenderDrawLine per span.
+*/
+int software = 1;
+Uint32 *framebuffer = NULL;
+SDL_Texture *frame_texture = NULL;
+Uint32 pixel_array[16];			  // color_array in ARGB8888
+int dirty_top = WINDOW_HEIGHT; // Rows changed since the last upload
+int dirty_bottom = 0;
+
+/*
+Frames are paced by the display: with vsync (the default) the renderer
+is accelerated and SDL_RenderPresent waits for the refresh, without it
+(-novsync) backend_wait sleeps until the next refresh on the
+performance counter. The time between presents goes into a rolling
+histogram of the last FRAME_HISTORY frames, printed when the game ends.
+*/
+#define FRAME_HISTORY 1024
+#define FRAME_BUCKETS 101 // 0.5ms each up to 50ms, and a last one for anything longer
+int vsync = 1;
+Uint64 frame_period = 0;  // Performance counter ticks between two refreshes
+Uint64 last_present = 0;  // Zero after a wait for a key, so time spent in the menus isn't a frame
+Uint64 wait_end = 0;	  // When the current frame started being drawn
+Uint64 frame_times[FRAME_HISTORY];
+Uint64 frame_busy[FRAME_HISTORY]; // Time spent drawing, the rest of the frame is headroom
+int frame_buckets[FRAME_BUCKETS];
+int frame_count = 0; // Frames recorded in total, the last FRAME_HISTORY are kept
+
+void RecordFrame(Uint64 time, Uint64 busy);
+void PrintFrameTimes(void);
+
+/*
+Text is drawn from a glyph atlas made once at startup from VGA.ttf:
+a mask of every printable character, and for the renderer a texture
+holding each character in each of the 16 colors, a row per color.
+A string is then a run of mask copies or atlas SDL_RenderCopy calls,
+with no surface or texture created while the game runs.
+*/
+#define GLYPH_FIRST ' '
+#define GLYPH_COUNT 95 // ' ' to '~'
+int glyph_width = 8;
+int glyph_height = 16;
+Uint8 *glyph_masks = NULL;		 // GLYPH_COUNT cells of glyph_width x glyph_height, non zero where the glyph is set
+SDL_Texture *glyph_atlas = NULL; // GLYPH_COUNT columns, 16 rows
+
+int CreateGlyphAtlas(void);
+void BlitGlyph(int x, int y, const Uint8 *mask, int color);
 void FillRect(int x, int y, int w, int h, int color);
 void FillCircle(int x, int y, int r, int color);
 void FillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color);
 
-void init_space_ship() // Function that places space_ship in the bottom middle
+/*
+The game itself lives in the shared core (Game/game.c), this file only
+connects it to SDL: the framebuffer or the renderer for drawing, the
+event queue for keys and SDL's timers for time.
+*/
+
+void *backend_alloc(unsigned size)
 {
-	space_ship.x = (WINDOW_WIDTH - 71) / 2; // pos = middle bottom
-	space_ship.y = WINDOW_HEIGHT - 30;
+	return malloc(size);
 }
 
-void init_asteroids() // Function that clears and initializes the asteroids[]
+void backend_free(void *ptr)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		asteroids[i].active = false; // Disable all asteroids so they can be (re)spawn
-	}
+	free(ptr);
 }
 
-void kprint_at(int x, int y, const char *str, int color)
+void backend_clear(void)
 {
-	SDL_Surface *surface = TTF_RenderText_Solid(font, str, color_array[color]);
-	if (surface == NULL)
-		return;
-	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-	if (texture == NULL)
+	if (software)
 	{
-		SDL_FreeSurface(surface);
+		FillRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, BLACK);
 		return;
 	}
-	SDL_Rect dstRect = {x, y, surface->w, surface->h}; // Position and size
-	SDL_RenderCopy(renderer, texture, NULL, &dstRect);
-
-	SDL_DestroyTexture(texture);
-	SDL_FreeSurface(surface);
-}
-
-void clear_screen()
-{
 	SDL_SetRenderDrawColor(renderer, color_array[BLACK].r, color_array[BLACK].g, color_array[BLACK].b, color_array[BLACK].a); // black
 	SDL_RenderClear(renderer);
 }
 
-void game_init() // Function that initializes and resets all game variables
+void backend_erase(int x, int y, int w, int h)
 {
-	init_space_ship();
-	init_asteroids();
-	bullet.active = false;
-	clear_screen();
-	score = 0;
-	life = 3;
+	FillRect(x, y, w, h, BLACK);
 }
 
-void print_score(bool draw) // Function that writes the score in the upper right corner of the screen
+void backend_print(int x, int y, const char *str, int color) // kprint_at
 {
-	if (draw) // Draw if true
+	if (!glyph_masks || (!software && !glyph_atlas)) // No font
+		return;
+	for (; *str != '\0'; str++, x += glyph_width) // For each character
 	{
-		int temp = score;
-		for (int i = 2; i > -1; i--)
+		int glyph = *str - GLYPH_FIRST;
+		if (glyph < 0 || glyph >= GLYPH_COUNT)
+			continue;
+		if (software)
+			BlitGlyph(x, y, glyph_masks + glyph * glyph_width * glyph_height, color);
+		else
 		{
-			Score[i] = (char)temp % 10 + '0';
-			temp /= 10;
+			SDL_Rect src = {glyph * glyph_width, color * glyph_height, glyph_width, glyph_height};
+			SDL_Rect dst = {x, y, glyph_width, glyph_height};
+			SDL_RenderCopy(renderer, glyph_atlas, &src, &dst); // Batched by the renderer with the rest of the frame
 		}
-		kprint_at(WINDOW_WIDTH - 11 * TEXT_PIXEL_WIDTH, 8, "Score:", LIGHT_CYAN);
-		kprint_at(WINDOW_WIDTH - 4 * TEXT_PIXEL_WIDTH, 8, Score, WHITE);
-	}
-	else // If false delete
-	{
-		FillRect(WINDOW_WIDTH - 11 * TEXT_PIXEL_WIDTH, 8, 88, 15, BLACK);
 	}
 }
 
-void print_life(bool draw) // Function that writes the life in the upper left corner of the screen
+void backend_draw_ship(int x, int y, int w, int h)
 {
-	if (draw) // Draw if true
-	{
-		char life_char[2] = {(char)life + '0', '\0'};
-		kprint_at(8, 8, "Life:", LIGHT_GREEN);
-		kprint_at(8 + 6 * TEXT_PIXEL_WIDTH, 8, life_char, WHITE);
-	}
-	else // If false delete
-	{
-		FillRect(8, 8, 60, 15, BLACK);
-	}
+	FillRect(x + 20, y + 15, 30, 5, DARK_GRAY);
+	FillTriangle(x, y + 30, x + 20, y + 25, x + 30, y + 2, WHITE);
+	FillTriangle(x + 71, y + 30, x + 51, y + 25, x + 41, y + 2, WHITE);
+	FillTriangle(x + 30, y + 15, x + 36, y, x + 41, y + 15, LIGHT_RED);
+	FillCircle(x + 35, y + 2, 2, YELLOW);
 }
 
-void move_and_fire_space_ship() // Function that takes keyboard inputs and determines the movements of the spaceship and the starting point of the bullet according to these inputs
+void backend_draw_bullet(int x, int y, int w, int h)
 {
-	if (key_pressed)
-	{
-		switch (current_key) // If the same or a different key is pressed again
-		{
-		// case 'w':
-		// 	space_ship.y--;
-		// 	break;
-		// case 's':
-		// 	space_ship.y++;
-		// 	break;
-		case 'a':
-			if (space_ship.x > 5)
-				space_ship.x -= 5;
-			break;
-		case 'd':
-			if (space_ship.x < WINDOW_WIDTH - 75)
-				space_ship.x += 5;
-			break;
-		case ' ':
-			if (!bullet.active) // If a bullet has been fired, a new bullet cannot be fired until that bullet hits something.
-			{
-				bullet.y = space_ship.y + 10;
-				bullet.x = space_ship.x + 34;
-				bullet.active = true;
-			}
-			break;
-		case 'r':
-			game_restart = true;
-			break;
-		case 'p':
-			game_pause = true;
-			break;
-		}
-		key_pressed = false; // After the key is processed, the flag will be set to false so that it does not enter the same place again.
-	}
+	FillRect(x, y, w, h, YELLOW);
 }
 
-void draw_space_ship(bool draw) // Function that draws and deletes the space_ship
+void backend_draw_asteroid(int x, int y, int w, int h, int phase, int exploding) // Size depends on the phase and color on the explosion
 {
-	if (draw) // Draw space_ship if true
-	{
-		FillRect(space_ship.x + 20, space_ship.y + 15, 30, 5, DARK_GRAY);
-		FillTriangle(space_ship.x, space_ship.y + 30, space_ship.x + 20, space_ship.y + 25, space_ship.x + 30, space_ship.y + 2, WHITE);
-		FillTriangle(space_ship.x + 71, space_ship.y + 30, space_ship.x + 51, space_ship.y + 25, space_ship.x + 41, space_ship.y + 2, WHITE);
-		FillTriangle(space_ship.x + 30, space_ship.y + 15, space_ship.x + 36, space_ship.y, space_ship.x + 41, space_ship.y + 15, LIGHT_RED);
-		FillCircle(space_ship.x + 35, space_ship.y + 2, 2, YELLOW);
-	}
-	else // If false delete
-	{
-		FillRect(space_ship.x, space_ship.y, 71, 30, BLACK);
-		// graphics_rect(&graphics_root, space_ship.x, space_ship.y, 71, 30, color_array[WHITE]);
-	}
+	FillCircle(x + w / 2, y + h / 2, w / 2, exploding ? RED : LIGHT_GRAY);
 }
 
-void move_bullets() // Function that moves the bullet
+void backend_draw_fragment(int x, int y, int w, int h, int color)
 {
-	if (bullet.y > 10 && bullet.active) // If the bullet doesn't reach the top, move the bullet up
-	{
-		bullet.y -= 20;
-	}
-	else if (bullet.active) // If the bullet has reached the top and is active, deactivate the bullet so it can be fired again
-	{
-		bullet.active = false;
-	}
+	FillRect(x, y, w, h, color);
 }
 
-void draw_bullets(bool draw) //
+void backend_present(void)
 {
-	if (draw && bullet.active) // Draw  bullet if the bullet is active and true
+	if (software && dirty_top < dirty_bottom) // Upload only the rows drawn since the last frame, the texture keeps the rest
 	{
-		FillRect(bullet.x, bullet.y, 3, 10, YELLOW);
-	}
-	else // If false delete
-	{
-		FillRect(bullet.x, bullet.y, 3, 10, BLACK);
+		SDL_Rect rows = {0, dirty_top, WINDOW_WIDTH, dirty_bottom - dirty_top};
+		void *pixels;
+		int pitch;
+		if (SDL_LockTexture(frame_texture, &rows, &pixels, &pitch) == 0)
+		{
+			for (int y = 0; y < rows.h; y++)
+				memcpy((char *)pixels + y * pitch, framebuffer + (dirty_top + y) * WINDOW_WIDTH, WINDOW_WIDTH * sizeof(Uint32));
+			SDL_UnlockTexture(frame_texture);
+		}
+		dirty_top = WINDOW_HEIGHT;
+		dirty_bottom = 0;
 	}
+	if (software)
+		SDL_RenderCopy(renderer, frame_texture, NULL, NULL);
+	Uint64 present_start = SDL_GetPerformanceCounter();
+	SDL_RenderPresent(renderer);
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (last_present)
+		RecordFrame(now - last_present, present_start - wait_end);
+	last_present = now;
+	wait_end = now;
 }
 
-void spawn_asteroids() // Function that spawns passive asteroids from a random x location
+int backend_read_key(void) // Read char using event pool
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
+	while (SDL_PollEvent(&event))
 	{
-		if (!asteroids[i].active)
-		{
-			asteroids[i].x = rand() % (WINDOW_WIDTH - 130 - 100) + 100; // 100 - (WINDOW_WIDTH - 130) range
-			asteroids[i].y = 70;
-			asteroids[i].explode = false;
-			asteroids[i].phase = 0;
-			asteroids[i].active = true;
-			return;
-		}
+		if (event.type == SDL_QUIT)
+			return GAME_KEY_QUIT;
+		else if (event.type == SDL_KEYDOWN && event.key.keysym.sym < 128)
+			return event.key.keysym.sym;
 	}
+	return 0;
 }
 
-void move_asteroids()
+int backend_key_held(int key) // SDL keeps the keyboard state up to date while polling events
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		if (asteroids[i].active) // Active ones move
-		{
-			asteroids[i].y += 10;
-			if (asteroids[i].explode)
-			{
-				asteroids[i].explode = false; // Reset explosion status when you move
-				if (asteroids[i].phase < 3)	  // If the size of asteroid is not the smalles, reduce the size
-				{
-					asteroids[i].phase++; // increasing phase means decreasing size
-				}
-				else // If it becomes the smallest, deactivate it
-					asteroids[i].active = false;
-			}
-			if ((asteroids[i].x > space_ship.x && asteroids[i].x < space_ship.x + 71 && asteroids[i].y > space_ship.y - 55) || (asteroids[i].y > WINDOW_HEIGHT - 55)) // If it reaches the bottom of the screen (below the spaceship), lose life and deactivate.
-			{
-				asteroids[i].active = false;
-				life--;
-			}
-		}
-	}
+	const Uint8 *state = SDL_GetKeyboardState(NULL);
+	return state[SDL_GetScancodeFromKey(key)];
 }
 
-void draw_asteroid(int id, bool draw) // Function to draw a single Asteroid and determine its hitboxes
+unsigned backend_millis(void)
 {
-	if (asteroids[id].active)
+	return SDL_GetTicks();
+}
+
+void backend_wait(int millis) // Sleep until the next refresh, or a key. Wakes on any event, which stays in the queue for backend_read_key
+{
+	if (millis == GAME_WAIT_KEY)
+	{
+		SDL_WaitEvent(NULL);
+		last_present = 0;
+	}
+	else if (millis > 0 && !vsync && last_present) // With vsync, SDL_RenderPresent has already waited
 	{
-		switch (asteroids[id].phase) // Enter one of the cases depending on the phase of the active asteroids
+		Uint64 frequency = SDL_GetPerformanceFrequency();
+		Uint64 deadline = last_present + frame_period;
+		Uint64 now = SDL_GetPerformanceCounter();
+		while (now < deadline)
 		{
-		case 0:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 55, LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 55, RED);
-			}
-			else
-			{
-				FillRect(asteroids[id].x - 55, asteroids[id].y - 55, 112, 112, BLACK);
-			}
-			break;
-
-		case 1:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 40, LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 40, RED);
-			}
-			else
+			Uint64 left = (deadline - now) * 1000 / frequency;
+			if (left >= 2) // Sleep while it is safely more than the timer's 1ms resolution
 			{
-				FillRect(asteroids[id].x - 40, asteroids[id].y - 40, 82, 82, BLACK);
-			}
-			break;
-
-		case 2:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 25, LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 25, RED);
+				if (SDL_WaitEventTimeout(NULL, left - 1))
+					break;
 			}
 			else
-			{
-				FillRect(asteroids[id].x - 25, asteroids[id].y - 25, 52, 52, BLACK);
-			}
-			break;
-
-		case 3:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 15, LIGHT_GRAY);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				FillCircle(asteroids[id].x, asteroids[id].y, 15, RED);
-			}
-			else
-			{
-				FillRect(asteroids[id].x - 15, asteroids[id].y - 15, 32, 32, BLACK);
-			}
-			break;
+				SDL_Delay(0); // Let the other threads run, the last millisecond is measured on the counter
+			now = SDL_GetPerformanceCounter();
 		}
 	}
+	wait_end = SDL_GetPerformanceCounter();
 }
 
-void draw_asteroids(bool draw) // Function to draw all asteroids
+unsigned backend_timer(void)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		draw_asteroid(i, draw); // We draw them all one by one using the method
-	}
+	return (unsigned)SDL_GetPerformanceCounter();
 }
 
-SDL_Color GetPixelColor(int pixel_X, int pixel_Y)
+unsigned backend_timer_usec(unsigned ticks)
 {
-	SDL_Color pixelColor;
-	Uint8 *pPixel = (Uint8 *)getPixel_Surface->pixels + pixel_Y * getPixel_Surface->pitch + pixel_X * getPixel_bpp;
+	return (Uint64)ticks * 1000000 / SDL_GetPerformanceFrequency();
+}
 
-	Uint32 pixelData;
+int main(int argc, char *argv[])
+{
+	struct game_config config;
 
-	switch (getPixel_bpp)
+	for (int i = 1; i < argc; i++)
 	{
-	case 1:
-		pixelData = *pPixel;
-		break;
-	case 2:
-		pixelData = *(Uint16 *)pPixel;
-		break;
-	case 3:
-		if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
-			pixelData = pPixel[0] << 16 | pPixel[1] << 8 | pPixel[2];
+		if (!strcmp(argv[i], "-r"))
+			software = 0;
+		else if (!strcmp(argv[i], "-novsync"))
+			vsync = 0;
 		else
-			pixelData = pPixel[0] | pPixel[1] << 8 | pPixel[2] << 16;
-		break;
-	case 4:
-		pixelData = *(Uint32 *)pPixel;
-		break;
+		{
+			fprintf(stderr, "usage: %s [-r] [-novsync]\n", argv[0]);
+			return 1;
+		}
 	}
 
-	SDL_GetRGBA(pixelData, getPixel_Surface->format, &pixelColor.r, &pixelColor.g, &pixelColor.b, &pixelColor.a);
-	return pixelColor;
-}
-
-bool check_collision(int x, int y) // Function that controls simple color-check collision
-{
-	SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, getPixel_Surface->pixels, getPixel_Surface->pitch);
-	for (int i = x; i < x + 3; i++)
+	SDL_Init(SDL_INIT_VIDEO);
+	window = SDL_CreateWindow("Space Shooter", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, 0);
+	if (!window)
 	{
-		SDL_Color color = GetPixelColor(x, y);
-		if ((color.r != 0 && 0xAA) || color.g != 0 || color.b != 0)
-		{
-			return true;
-		}
+		fprintf(stderr, "couldn't create the window: %s\n", SDL_GetError());
+		return 1;
 	}
-	return false;
-}
-void collision_event() // Function that handles collisions and life checking
-{
-	if (check_collision(bullet.x, bullet.y) && bullet.y > 16) // If collision find out which asteroid it hit
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+	if (!renderer) // No accelerated renderer, take whatever SDL has
 	{
+		vsync = 0;
+		renderer = SDL_CreateRenderer(window, -1, 0);
+	}
+	if (!renderer)
+	{
+		fprintf(stderr, "couldn't create the renderer: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	SDL_DisplayMode mode;
+	int refresh_rate = 60; // When the display doesn't say
+	if (SDL_GetCurrentDisplayMode(0, &mode) == 0 && mode.refresh_rate > 0)
+		refresh_rate = mode.refresh_rate;
+	frame_period = SDL_GetPerformanceFrequency() / refresh_rate;
+	TTF_Init();
+	font = TTF_OpenFont("VGA.ttf", 16);
 
-		float closest_dist = 1000.0f;
-		int closest_id = 0;
-		for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++) // To calculate all distances and get the closest one
+	for (int i = 0; i < 16; i++)
+		pixel_array[i] = 0xFF000000 | color_array[i].r << 16 | color_array[i].g << 8 | color_array[i].b;
+
+	if (software)
+	{
+		framebuffer = malloc(WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(Uint32));
+		frame_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WINDOW_WIDTH, WINDOW_HEIGHT);
+		if (!framebuffer || !frame_texture) // Fall back to the renderer
 		{
-			// Formula for distance between two points sqrt2(pow(x1-x2)+pow(y1-y2))
-			int asteroid_dist = sqrt((asteroids[i].x - bullet.x) * (asteroids[i].x - bullet.x) + (asteroids[i].y - bullet.y) * (asteroids[i].y - bullet.y));
-			if (closest_dist > asteroid_dist)
-			{
-				closest_dist = asteroid_dist;
-				closest_id = i;
-			}
+			free(framebuffer);
+			framebuffer = NULL;
+			software = 0;
 		}
-		// After find we reset bullet and
-		bullet.x = 0;
-		bullet.y = 0;
-		bullet.active = false;
-		asteroids[closest_id].explode = true; // Set the explode flag (of the asteroid we found) to true
-		score++;
 	}
-	if (life <= 0)
-		game_over = true;
+
+	if (!CreateGlyphAtlas())
+		fprintf(stderr, "couldn't load VGA.ttf, text won't be shown\n");
+
+	game_config_graphics(&config, WINDOW_WIDTH, WINDOW_HEIGHT);
+	config.text_width = glyph_width; // VGA.ttf at 16 points is 8x16
+	config.text_height = glyph_height;
+	config.line_height = glyph_height;
+	struct game *game = game_create(&config, time(NULL));
+	if (game)
+	{
+		game_run(game);
+		game_delete(game);
+	}
+	PrintFrameTimes();
+
+	if (glyph_atlas)
+		SDL_DestroyTexture(glyph_atlas);
+	free(glyph_masks);
+	TTF_Quit();
+	if (frame_texture)
+		SDL_DestroyTexture(frame_texture);
+	free(framebuffer);
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return 0;
 }
 
-int main()
+void Dirty(int y0, int y1) // Rows y0 to y1 - 1 of the framebuffer have changed
 {
+	if (y0 < dirty_top)
+		dirty_top = y0;
+	if (y1 > dirty_bottom)
+		dirty_bottom = y1;
+}
 
-	srand(time(NULL));
-	SDL_Init(SDL_INIT_VIDEO);
-	SDL_CreateWindowAndRenderer(WINDOW_WIDTH, WINDOW_HEIGHT, 0, &window, &renderer);
-	TTF_Init();
-	font = TTF_OpenFont("VGA.ttf", 16);
-	SDL_RenderPresent(renderer);
-	getPixel_Surface = SDL_CreateRGBSurface(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
-	SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, getPixel_Surface->pixels, getPixel_Surface->pitch);
-	getPixel_bpp = getPixel_Surface->format->BytesPerPixel;
-Restart_Game:
-	game_init();
-
-	if (!game_start)
-		kprint_at((WINDOW_WIDTH - 11 * TEXT_PIXEL_WIDTH) / 2, WINDOW_HEIGHT / 2, "Start Game", LIGHT_GRAY); // Appears only on first startup
-	game_start = true;
-
-	if (game_restart)
-	{ // Appears on every restart
-		kprint_at((WINDOW_WIDTH - 10 * TEXT_PIXEL_WIDTH) / 2, (WINDOW_HEIGHT / 2) - 16, "Score:", LIGHT_CYAN);
-		kprint_at(((WINDOW_WIDTH - 10 * TEXT_PIXEL_WIDTH) / 2) + 7 * TEXT_PIXEL_WIDTH, (WINDOW_HEIGHT / 2) - 16, Score, WHITE);
-		kprint_at((WINDOW_WIDTH - 13 * TEXT_PIXEL_WIDTH) / 2, WINDOW_HEIGHT / 2, "Restart Game", LIGHT_GRAY);
+void Span(int x1, int x2, int y, int color) // Horizontal line from x1 to x2 included, the one primitive every shape is made of
+{
+	if (x1 > x2)
+	{
+		int t = x1;
+		x1 = x2;
+		x2 = t;
 	}
-	game_restart = false;
-
-	if (game_over)
-	{ // Appears on every gameover
-		kprint_at((WINDOW_WIDTH - 10 * TEXT_PIXEL_WIDTH) / 2, (WINDOW_HEIGHT / 2) - 16, "Score:", LIGHT_CYAN);
-		kprint_at(((WINDOW_WIDTH - 10 * TEXT_PIXEL_WIDTH) / 2) + 7 * TEXT_PIXEL_WIDTH, (WINDOW_HEIGHT / 2) - 16, Score, WHITE);
-		kprint_at((WINDOW_WIDTH - 10 * TEXT_PIXEL_WIDTH) / 2, WINDOW_HEIGHT / 2, "Game Over", LIGHT_GRAY);
+	if (!software)
+	{
+		SDL_SetRenderDrawColor(renderer, color_array[color].r, color_array[color].g, color_array[color].b, color_array[color].a);
+		SDL_RenderDrawLine(renderer, x1, y, x2, y);
+		return;
 	}
-	game_over = false;
-
-	for (int i = 0; i < 3; i++)
-		Score[i] = '0'; // Clear Score Array
-	int loop_step = 0;	// We create(reset) the loop counter to create delay.
+	if (y < 0 || y >= WINDOW_HEIGHT)
+		return;
+	if (x1 < 0)
+		x1 = 0;
+	if (x2 >= WINDOW_WIDTH)
+		x2 = WINDOW_WIDTH - 1;
+	if (x1 > x2)
+		return;
+	Uint32 *p = framebuffer + y * WINDOW_WIDTH;
+	Uint32 pixel = pixel_array[color];
+	for (int x = x1; x <= x2; x++)
+		p[x] = pixel;
+	Dirty(y, y + 1);
+}
 
-	kprint_at((WINDOW_WIDTH - 33 * TEXT_PIXEL_WIDTH) / 2, 16, "180101012 - Ibrahim Yusuf Cosgun", DARK_GRAY);
+int FrameBucket(Uint64 time) // Function that returns the histogram bucket of a frame time
+{
+	Uint64 bucket = time * 2000 / SDL_GetPerformanceFrequency();
+	return bucket < FRAME_BUCKETS - 1 ? bucket : FRAME_BUCKETS - 1;
+}
 
-Pause_Game:
-	if (game_pause)
-		kprint_at((WINDOW_WIDTH - 14 * TEXT_PIXEL_WIDTH) / 2, WINDOW_HEIGHT / 2, "Continue Game", LIGHT_GRAY);
-	game_pause = false;
+void RecordFrame(Uint64 time, Uint64 busy)
+{
+	int slot = frame_count % FRAME_HISTORY;
+	if (frame_count >= FRAME_HISTORY) // The oldest frame leaves the histogram
+		frame_buckets[FrameBucket(frame_times[slot])]--;
+	frame_times[slot] = time;
+	frame_busy[slot] = busy;
+	frame_buckets[FrameBucket(time)]++;
+	frame_count++;
+}
 
-	kprint_at((WINDOW_WIDTH - 14 * TEXT_PIXEL_WIDTH) / 2, (WINDOW_HEIGHT / 2) + 16, "Press [Enter]", DARK_GRAY); // Appears always
-	SDL_RenderPresent(renderer);
+void PrintFrameTimes(void)
+{
+	int frames = frame_count < FRAME_HISTORY ? frame_count : FRAME_HISTORY;
+	double to_ms = 1000.0 / SDL_GetPerformanceFrequency();
+	Uint64 total = 0, busy = 0, worst = 0;
 
-	while (current_key != '\r')
+	if (!frames)
+		return;
+	for (int i = 0; i < frames; i++)
 	{
-		while (SDL_PollEvent(&event))
-		{
-			if (event.type == SDL_QUIT)
-				quit = 1;
-			else if (event.type == SDL_KEYDOWN)
-			{
-				current_key = event.key.keysym.sym;
-			}
-		}				   // Read char using event pool
-		usleep(50 * 1000); // Sleep 50ms
+		total += frame_times[i];
+		busy += frame_busy[i];
+		if (frame_times[i] > worst)
+			worst = frame_times[i];
+	}
+	printf("last %d frames (%s): average %.2f ms, worst %.2f ms, drawing %.2f ms per frame (%.0f%% of the frame)\n",
+		   frames, vsync ? "vsync" : "no vsync", total * to_ms / frames, worst * to_ms, busy * to_ms / frames, total ? 100.0 * busy / total : 0);
+
+	int most = 1;
+	for (int i = 0; i < FRAME_BUCKETS; i++)
+		if (frame_buckets[i] > most)
+			most = frame_buckets[i];
+	for (int i = 0; i < FRAME_BUCKETS; i++)
+	{
+		if (!frame_buckets[i])
+			continue;
+		if (i < FRAME_BUCKETS - 1)
+			printf("%4.1f - %4.1f ms %5d ", i * 0.5, i * 0.5 + 0.5, frame_buckets[i]);
+		else
+			printf("%4d ms or more %5d ", (FRAME_BUCKETS - 1) / 2, frame_buckets[i]);
+		for (int j = 0; j < frame_buckets[i] * 50 / most; j++)
+			putchar('#');
+		putchar('\n');
 	}
+}
 
-	clear_screen();
-	quit = 0;
-	while (!quit)
+int CreateGlyphAtlas(void) // Function that renders every character once, returns 0 if the font couldn't be used
+{
+	SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+	int advance;
+
+	if (!font || TTF_GlyphMetrics(font, 'M', NULL, NULL, NULL, NULL, &advance) != 0)
+		return 0;
+	glyph_width = advance; // VGA.ttf is monospaced
+	glyph_height = TTF_FontHeight(font);
+	glyph_masks = calloc(GLYPH_COUNT, glyph_width * glyph_height);
+	if (!glyph_masks)
+		return 0;
+
+	for (int glyph = 0; glyph < GLYPH_COUNT; glyph++)
 	{
-		while (SDL_PollEvent(&event))
-		{
-			if (event.type == SDL_QUIT)
-				quit = 1;
-			else if (event.type == SDL_KEYDOWN)
-			{
-				current_key = event.key.keysym.sym;
-				key_pressed = true;
-			}
-		}// Read char using event pool
-		if (game_restart || game_over) // Proper reset with goto in case of gameover or restart of the game
-			goto Restart_Game;
-
-		if (game_pause) // Pause by just freezing the screen without resetting game objects (Buffer is not a game object, it makes the printing process faster and in one piece.)
-			goto Pause_Game;
-
-		usleep(50 * 1000); // Sleep 50ms
-
-		// Clear
-		draw_space_ship(false);
-		draw_bullets(false);
-		print_score(false);
-		print_life(false);
+		SDL_Surface *surface = TTF_RenderGlyph_Solid(font, GLYPH_FIRST + glyph, white); // 8 bit, index 0 is the background
+		if (!surface)
+			continue;
+		Uint8 *mask = glyph_masks + glyph * glyph_width * glyph_height;
+		for (int j = 0; j < surface->h && j < glyph_height; j++)
+			for (int i = 0; i < surface->w && i < glyph_width; i++)
+				mask[j * glyph_width + i] = ((const Uint8 *)surface->pixels)[j * surface->pitch + i];
+		SDL_FreeSurface(surface);
+	}
 
-		// Move and do Events
-		move_and_fire_space_ship();
-		move_bullets();
-		if (loop_step++ % 120 == 0)
-		{
-			spawn_asteroids();
-		}
-		if (loop_step % 10 == 0)
-		{
-			// Before Movement Clear Asteroids
-			draw_asteroids(false);
-			move_asteroids();
-		}
-		collision_event();
-
-		// Print
-		draw_space_ship(true);
-		draw_bullets(true);
-		draw_asteroids(true);
-		print_score(true);
-		print_life(true);
-		SDL_RenderPresent(renderer);
+	if (software)
+		return 1;
+
+	int atlas_width = GLYPH_COUNT * glyph_width;
+	Uint32 *pixels = malloc(atlas_width * 16 * glyph_height * sizeof(Uint32));
+	if (!pixels)
+		return 0;
+	for (int color = 0; color < 16; color++)
+		for (int glyph = 0; glyph < GLYPH_COUNT; glyph++)
+			for (int j = 0; j < glyph_height; j++)
+				for (int i = 0; i < glyph_width; i++)
+					pixels[(color * glyph_height + j) * atlas_width + glyph * glyph_width + i] =
+						glyph_masks[(glyph * glyph_height + j) * glyph_width + i] ? pixel_array[color] : 0; // Transparent around the glyph
+	glyph_atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, atlas_width, 16 * glyph_height);
+	if (glyph_atlas)
+	{
+		SDL_UpdateTexture(glyph_atlas, NULL, pixels, atlas_width * sizeof(Uint32));
+		SDL_SetTextureBlendMode(glyph_atlas, SDL_BLENDMODE_BLEND);
 	}
-	TTF_Quit();
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
-	SDL_Quit();
-	return 0;
+	free(pixels);
+	return glyph_atlas != NULL;
 }
 
-void FillRect(int x, int y, int w, int h, int color)
+void BlitGlyph(int x, int y, const Uint8 *mask, int color) // Copies the set pixels of one glyph into the framebuffer
 {
-	SDL_SetRenderDrawColor(renderer, color_array[color].r, color_array[color].g, color_array[color].b, color_array[color].a);
-	SDL_Rect rect_area = {x, y, w, h};
-	SDL_RenderFillRect(renderer, &rect_area);
-	SDL_SetRenderDrawColor(renderer, color_array[BLACK].r, color_array[BLACK].g, color_array[BLACK].b, color_array[BLACK].a);
+	Uint32 pixel = pixel_array[color];
+	for (int j = 0; j < glyph_height; j++)
+	{
+		if (y + j < 0 || y + j >= WINDOW_HEIGHT)
+			continue;
+		Uint32 *dst = framebuffer + (y + j) * WINDOW_WIDTH;
+		for (int i = 0; i < glyph_width; i++)
+			if (mask[j * glyph_width + i] && x + i >= 0 && x + i < WINDOW_WIDTH)
+				dst[x + i] = pixel;
+	}
+	if (y < WINDOW_HEIGHT && y + glyph_height > 0)
+		Dirty(y < 0 ? 0 : y, y + glyph_height > WINDOW_HEIGHT ? WINDOW_HEIGHT : y + glyph_height);
 }
-void FillCircle(int x, int y, int r, int color)
+
+void FillRect(int x, int y, int w, int h, int color)
 {
-	SDL_SetRenderDrawColor(renderer, color_array[color].r, color_array[color].g, color_array[color].b, color_array[color].a);
-	int i, j;
-	float sinus = 0.70710678118;
-	// This is the distance on the axis from sin(90) to sin(45).
-	int range = r / (2 * sinus);
-	for (int i = r; i >= range; --i)
+	if (!software)
 	{
-		int j = sqrt(r * r - i * i);
-		for (int k = -j; k <= j; k++)
-		{
-			// We draw all the 4 sides at the same time.
-			SDL_RenderDrawPoint(renderer, x - k, y + i);
-			SDL_RenderDrawPoint(renderer, x - k, y - i);
-			SDL_RenderDrawPoint(renderer, x + i, y + k);
-			SDL_RenderDrawPoint(renderer, x - i, y - k);
-		}
+		SDL_SetRenderDrawColor(renderer, color_array[color].r, color_array[color].g, color_array[color].b, color_array[color].a);
+		SDL_Rect rect_area = {x, y, w, h};
+		SDL_RenderFillRect(renderer, &rect_area);
+		return;
 	}
-	// To fill the circle we draw the circumscribed square.
-	range = r * sinus;
-	for (int i = x - range + 1; i < x + range; i++)
+	for (int j = y; j < y + h; j++)
+		Span(x, x + w - 1, j, color);
+}
+
+void FillCircle(int x, int y, int r, int color) // One span per row, the widest that stays inside the circle
+{
+	int dx = r;
+	for (int dy = 0; dy <= r; dy++)
 	{
-		for (int j = y - range + 1; j < y + range; j++)
-		{
-			SDL_RenderDrawPoint(renderer, i, j);
-		}
+		while (dx * dx + dy * dy > r * r) // dx only shrinks as dy grows
+			dx--;
+		Span(x - dx, x + dx, y + dy, color);
+		if (dy)
+			Span(x - dx, x + dx, y - dy, color);
 	}
-	SDL_SetRenderDrawColor(renderer, color_array[BLACK].r, color_array[BLACK].g, color_array[BLACK].b, color_array[BLACK].a);
 }
 
 #define SWAP(x, y)       \
@@ -620,17 +527,9 @@ void FillCircle(int x, int y, int r, int color)
 		(y) = (x) ^ (y); \
 		(x) = (x) ^ (y); \
 	} while (0)
-void HLine(int x1, int x2, int y)
-{
-	if (x1 >= x2)
-		SWAP(x1, x2);
-	for (; x1 <= x2; x1++)
-		SDL_RenderDrawPoint(renderer, x1, y);
-}
 // Fill a triangle - slope method
 void FillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color)
 {
-	SDL_SetRenderDrawColor(renderer, color_array[color].r, color_array[color].g, color_array[color].b, color_array[color].a);
 	int a, b, y, last;
 	// Sort coordinates by Y order (y2 >= y1 >= y0)
 	if (y0 > y1)
@@ -660,7 +559,7 @@ void FillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color)
 			a = x2;
 		else if (x2 > b)
 			b = x2;
-		HLine(a, b, y0);
+		Span(a, b, y0, color);
 		return;
 	}
 
@@ -692,7 +591,7 @@ void FillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color)
 		sb += dx02;
 		// longhand a = x0 + (x1 - x0) * (y - y0) / (y1 - y0)
 		//          b = x0 + (x2 - x0) * (y - y0) / (y2 - y0)
-		HLine(a, b, y);
+		Span(a, b, y, color);
 	}
 
 	// For lower part of triangle, find scanline crossings for segment
@@ -707,7 +606,6 @@ void FillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color)
 		sb += dx02;
 		// longhand a = x1 + (x2 - x1) * (y - y1) / (y2 - y1)
 		//          b = x0 + (x2 - x0) * (y - y0) / (y2 - y0)
-		HLine(a, b, y);
+		Span(a, b, y, color);
 	}
-	SDL_SetRenderDrawColor(renderer, color_array[BLACK].r, color_array[BLACK].g, color_array[BLACK].b, color_array[BLACK].a);
 }
\ No newline at end of file
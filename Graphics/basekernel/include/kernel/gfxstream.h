@@ -7,6 +7,37 @@ See the file LICENSE for details.
 #ifndef KERNEL_GFXSTREAM_H
 #define KERNEL_GFXSTREAM_H
 
+#include "kernel/types.h"
+
+/*
+A gfxstream is an array of words written to a window: each command is
+an opcode followed by its arguments, one word each.  If the opcode has
+GRAPHICS_PACKED set, the arguments are instead signed 16 bit values
+packed two to a word, low half first.  Some commands carry trailing
+data after their arguments:
+
+GRAPHICS_FGCOLOR   r g b
+GRAPHICS_BGCOLOR   r g b
+GRAPHICS_LINE      x y w h
+GRAPHICS_RECT      x y w h           filled with the foreground color
+GRAPHICS_CLEAR     x y w h           filled with the background color
+GRAPHICS_TEXT      x y n             then n characters, one per word,
+                                     or four per word if packed
+GRAPHICS_TRI       x0 y0 x1 y1 x2 y2
+GRAPHICS_CIRCLE    x y r
+GRAPHICS_SPANS     y n               then n pairs x1 x2 for rows y..y+n-1,
+                                     as two words, or one word if packed
+GRAPHICS_COPY_AREA sx sy w h dx dy   overlapping areas are allowed
+GRAPHICS_UPLOAD    handle w h        then w*h pixels 0x00RRGGBB, one per word
+GRAPHICS_BLIT      handle x y keyed  keyed leaves out the background color
+
+Uploaded bitmaps stay with the window under their handle until they
+are replaced, so a sprite crosses the syscall boundary once.  The
+kernel checks a whole batch before drawing any of it, and refuses it
+if any coordinate, size or radius lies outside -GRAPHICS_COORD_MAX to
+GRAPHICS_COORD_MAX, which keeps the rasterizers' arithmetic in range.
+*/
+
 typedef enum {
 	GRAPHICS_END = 0,
 	GRAPHICS_FGCOLOR,
@@ -14,7 +45,44 @@ typedef enum {
 	GRAPHICS_LINE,
 	GRAPHICS_RECT,
 	GRAPHICS_CLEAR,
-	GRAPHICS_TEXT
+	GRAPHICS_TEXT,
+	GRAPHICS_TRI,
+	GRAPHICS_CIRCLE,
+	GRAPHICS_SPANS,
+	GRAPHICS_COPY_AREA,
+	GRAPHICS_UPLOAD,
+	GRAPHICS_BLIT,
+	GRAPHICS_MAX_COMMAND
 } graphics_command_t;
 
+#define GRAPHICS_PACKED 0x100
+
+#define GRAPHICS_COORD_MAX 8191
+
+#define GRAPHICS_BITMAP_HANDLES 16
+#define GRAPHICS_BITMAP_MAX_SIZE 128
+
+/*
+A window's pixel surface, as mapped into the process by
+syscall_window_surface.  Pixels are B,G,R (bpp 3) or B,G,R,X (bpp 4),
+the same layout as the screen, and rows are pitch bytes apart.
+Drawing into the surface reaches the screen only when the changed
+rectangles are passed to syscall_window_present.
+*/
+
+struct graphics_surface {
+	uint8_t *pixels;
+	int width;
+	int height;
+	int pitch;
+	int bpp;
+};
+
+struct graphics_rect {
+	int x;
+	int y;
+	int w;
+	int h;
+};
+
 #endif
@@ -50,6 +50,10 @@ typedef enum {
 	SYSCALL_SYSTEM_TIME,
 	SYSCALL_SYSTEM_RTC,
 	SYSCALL_DEVICE_DRIVER_STATS,
+	SYSCALL_WINDOW_SURFACE,
+	SYSCALL_WINDOW_PRESENT,
+	SYSCALL_WINDOW_MOVE,
+	SYSCALL_WINDOW_RAISE,
 	MAX_SYSCALL		// must be the last element in the enum
 } syscall_t;
 
@@ -19,6 +19,7 @@ int nw_post_events( struct nwindow *w, const struct event *e, int count );
 
 int nw_move( struct nwindow *w, int x, int y );
 int nw_resize( struct nwindow *w, int width, int height );
+int nw_raise( struct nwindow *w );
 int nw_fd( struct nwindow *w );
 
 void nw_fgcolor( struct nwindow *w, int r, int g, int b );
@@ -28,8 +29,33 @@ void nw_line   ( struct nwindow *w, int x, int y, int width, int height );
 void nw_rect   ( struct nwindow *w, int x, int y, int width, int height );
 void nw_char   ( struct nwindow *w, int x, int y, char c );
 void nw_string ( struct nwindow *w, int x, int y, const char *s );
+void nw_tri    ( struct nwindow *w, int x0, int y0, int x1, int y1, int x2, int y2 );
+void nw_circle ( struct nwindow *w, int x, int y, int r );
+void nw_spans  ( struct nwindow *w, int y, const int *x1, const int *x2, int count );
+void nw_copy_area( struct nwindow *w, int sx, int sy, int width, int height, int dx, int dy );
 void nw_flush  ( struct nwindow *w );
 
+/*
+nw_upload keeps a bitmap of 0x00RRGGBB pixels in the window under a
+handle from 0 to GRAPHICS_BITMAP_HANDLES-1, and nw_blit draws it.
+A keyed blit leaves out pixels of the background color.
+*/
+
+int  nw_upload ( struct nwindow *w, int handle, int width, int height, const int *pixels );
+void nw_blit   ( struct nwindow *w, int handle, int x, int y, int keyed );
+
+/*
+nw_surface maps the window's pixels into this process, returning
+null if that is not possible.  Draw into surface->pixels and then
+pass the rectangles that changed to nw_present to show them.
+Drawing commands and pixel writes take effect in the order they reach
+the window, so call nw_flush before writing pixels after drawing
+commands; nw_surface and nw_present flush for you.
+*/
+
+struct graphics_surface * nw_surface( struct nwindow *w );
+void nw_present( struct nwindow *w, const struct graphics_rect *rects, int count );
+
 
 
 #endif
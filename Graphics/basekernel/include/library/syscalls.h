@@ -9,6 +9,7 @@ See the file LICENSE for details.
 
 #include "kernel/types.h"
 #include "kernel/stats.h"
+#include "kernel/gfxstream.h"
 
 void syscall_debug(const char *str);
 
@@ -37,6 +38,13 @@ int syscall_open_window(int fd, int x, int y, int w, int h);
 int syscall_open_console(int fd);
 int syscall_open_pipe();
 
+/* Syscalls that give a window a pixel surface mapped into this process. */
+
+int syscall_window_surface(int fd, struct graphics_surface *s);
+int syscall_window_present(int fd, const struct graphics_rect *rects, int count);
+int syscall_window_move(int fd, int x, int y);
+int syscall_window_raise(int fd);
+
 /* Syscalls that manipulate kernel objects for this process. */
 
 int syscall_object_type(int fd);
@@ -7,6 +7,15 @@ See the file LICENSE for details.
 #include "bitmap.h"
 #include "kernelcore.h"
 #include "kmalloc.h"
+#include "page.h"
+
+/*
+Bitmaps larger than this are carved out of contiguous physical
+pages instead of the (small) kmalloc arena.  A full screen
+back buffer at 1024x768x32 is well over the kmalloc limit.
+*/
+
+#define BITMAP_KMALLOC_LIMIT (64*KILO)
 
 static struct bitmap root_bitmap;
 
@@ -14,18 +23,30 @@ struct bitmap *bitmap_create_root()
 {
 	root_bitmap.width = video_xres;
 	root_bitmap.height = video_yres;
-	root_bitmap.format = BITMAP_FORMAT_RGB;
+	root_bitmap.format = video_bpp == 32 ? BITMAP_FORMAT_XRGB : BITMAP_FORMAT_RGB;
+	root_bitmap.pitch = video_xbytes;
 	root_bitmap.data = video_buffer;
+	root_bitmap.npages = 0;
 	return &root_bitmap;
 }
 
-struct bitmap *bitmap_create(int width, int height, int format)
+static struct bitmap *bitmap_create_internal(int width, int height, int format, int paged)
 {
 	struct bitmap *b = kmalloc(sizeof(*b));
 	if(!b)
 		return 0;
 
-	b->data = kmalloc(width * height * 3);
+	uint32_t pitch = width * BITMAP_BYTES_PER_PIXEL(format);
+	uint32_t size = pitch * height;
+
+	if(paged || size > BITMAP_KMALLOC_LIMIT) {
+		b->npages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+		b->data = page_alloc_contiguous(b->npages, 1);
+	} else {
+		b->npages = 0;
+		b->data = kmalloc(size);
+	}
+
 	if(!b->data) {
 		kfree(b);
 		return 0;
@@ -34,12 +55,36 @@ struct bitmap *bitmap_create(int width, int height, int format)
 	b->width = width;
 	b->height = height;
 	b->format = format;
+	b->pitch = pitch;
 
 	return b;
 }
 
+struct bitmap *bitmap_create(int width, int height, int format)
+{
+	return bitmap_create_internal(width, height, format, 0);
+}
+
+/*
+Like bitmap_create, but the pixels always occupy whole pages of their
+own, so that they can be mapped into a process.
+*/
+
+struct bitmap *bitmap_create_paged(int width, int height, int format)
+{
+	return bitmap_create_internal(width, height, format, 1);
+}
+
 void bitmap_delete(struct bitmap *b)
 {
-	kfree(b->data);
+	uint32_t i;
+
+	if(b->npages) {
+		for(i = 0; i < b->npages; i++) {
+			page_free(b->data + i * PAGE_SIZE);
+		}
+	} else {
+		kfree(b->data);
+	}
 	kfree(b);
 }
@@ -12,16 +12,28 @@ See the file LICENSE for details.
 struct bitmap *bitmap_create_root();
 
 struct bitmap *bitmap_create(int width, int height, int format);
+struct bitmap *bitmap_create_paged(int width, int height, int format);
 void bitmap_delete(struct bitmap *b);
 
 struct bitmap {
 	uint32_t width;
 	uint32_t height;
 	uint32_t format;
+	uint32_t pitch;
 	uint8_t *data;
+	uint32_t npages;
 };
 
 #define BITMAP_FORMAT_RGB      0
 #define BITMAP_FORMAT_RGBA     1
+#define BITMAP_FORMAT_XRGB     2
+
+/*
+Pixels are stored as B,G,R or B,G,R,A, where A is the transparency.
+XRGB is the 32 bit screen layout B,G,R,X, where X is ignored.
+Rows are pitch bytes apart, which may be more than width pixels.
+*/
+
+#define BITMAP_BYTES_PER_PIXEL(format) ((format)==BITMAP_FORMAT_RGB ? 3 : 4)
 
 #endif
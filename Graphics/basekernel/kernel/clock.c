@@ -10,17 +10,28 @@ See the file LICENSE for details.
 #include "process.h"
 
 // Minimum PIT frequency is 18.2Hz.
-#define CLICKS_PER_SECOND 20
+// 100Hz gives clock_read and clock_wait a 10ms resolution.
+#define CLICKS_PER_SECOND 100
 
 #define TIMER0		0x40
+#define TIMER2		0x42
 #define TIMER_MODE	0x43
 #define SQUARE_WAVE     0x36
+#define ONE_SHOT2	0xb0
 #define TIMER_FREQ	1193182
 #define TIMER_COUNT	(((unsigned)TIMER_FREQ)/CLICKS_PER_SECOND)
 
+// Port 0x61 bit 0 gates timer 2, bit 1 connects it to the speaker,
+// and bit 5 reads back the timer 2 output.
+#define TIMER2_GATE	0x61
+
+#define CALIBRATE_MILLIS 10
+
 static uint32_t clicks = 0;
 static uint32_t seconds = 0;
 
+static uint32_t tsc_per_usec = 1;
+
 static struct list queue = { 0, 0 };
 
 static void clock_interrupt(int i, int code)
@@ -67,6 +78,42 @@ void clock_wait(uint32_t millis)
 	} while(total < millis);
 }
 
+uint32_t clock_tsc()
+{
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return lo;
+}
+
+uint32_t clock_tsc_usec(uint32_t cycles)
+{
+	return cycles / tsc_per_usec;
+}
+
+/*
+Count processor cycles while timer 2 counts down a fixed interval
+in one-shot mode.  This doesn't depend on the timer 0 interrupt,
+so it works before interrupts are enabled.
+*/
+
+static void clock_calibrate_tsc()
+{
+	uint32_t count = TIMER_FREQ / 1000 * CALIBRATE_MILLIS;
+	uint32_t start, stop;
+
+	outb((inb(TIMER2_GATE) & ~0x02) | 0x01, TIMER2_GATE);
+	outb(ONE_SHOT2, TIMER_MODE);
+	outb(count & 0xff, TIMER2);
+	outb((count >> 8) & 0xff, TIMER2);
+
+	start = clock_tsc();
+	while(!(inb(TIMER2_GATE) & 0x20)) { }
+	stop = clock_tsc();
+
+	tsc_per_usec = (stop - start) / (CALIBRATE_MILLIS * 1000);
+	if(tsc_per_usec == 0) tsc_per_usec = 1;
+}
+
 void clock_init()
 {
 	outb(SQUARE_WAVE, TIMER_MODE);
@@ -76,5 +123,7 @@ void clock_init()
 	interrupt_register(32, clock_interrupt);
 	interrupt_enable(32);
 
-	printf("clock: ticking\n");
+	clock_calibrate_tsc();
+
+	printf("clock: ticking, %d cycles/us\n", tsc_per_usec);
 }
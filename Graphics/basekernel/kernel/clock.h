@@ -19,4 +19,14 @@ clock_t clock_read();
 clock_t clock_diff(clock_t start, clock_t stop);
 void clock_wait(uint32_t millis);
 
+/*
+For timing short intervals, clock_tsc reads the low bits of the
+processor cycle counter, and clock_tsc_usec converts a difference
+of two readings to microseconds, using a rate calibrated against
+the PIT at startup.  Intervals must be shorter than about a second.
+*/
+
+uint32_t clock_tsc();
+uint32_t clock_tsc_usec(uint32_t cycles);
+
 #endif
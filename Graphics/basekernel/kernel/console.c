@@ -10,6 +10,27 @@ See the file LICENSE for details.
 #include "kmalloc.h"
 #include "string.h"
 
+/*
+The console keeps a grid of character cells, each a character and a
+color attribute, holding what should be on screen.  A second grid
+records what was last drawn.  Writing and scrolling only change the
+first grid and mark the rows they touch; console_flush then repaints
+the runs of cells that differ, once at the end of each write.
+*/
+
+struct console_cell {
+	char c;
+	uint8_t attr;	/* background in the high four bits, foreground in the low four */
+};
+
+#define CONSOLE_ATTR_DEFAULT 0x0f	/* white on black */
+#define CONSOLE_ATTR_INVALID 0xff	/* never matches, forces a repaint */
+
+/* The root console is created before kmalloc, so its grids are static. */
+
+#define CONSOLE_MAX_COLUMNS 160
+#define CONSOLE_MAX_ROWS    128
+
 struct console {
 	struct window *window;
 	struct graphics *gx;
@@ -19,17 +40,166 @@ struct console {
 	int ypos;
 	int onoff;
 	int refcount;
+	int attr;
+	int cursor_x;
+	int cursor_y;
+	struct console_cell *cells;
+	struct console_cell *shown;
+	uint8_t *dirty;
 };
 
 struct console console_root = {0};
 
-static struct graphics_color bgcolor = { 0, 0, 0 };
-static struct graphics_color fgcolor = { 255, 255, 255 };
+static struct console_cell root_cells[CONSOLE_MAX_COLUMNS * CONSOLE_MAX_ROWS];
+static struct console_cell root_shown[CONSOLE_MAX_COLUMNS * CONSOLE_MAX_ROWS];
+static uint8_t root_dirty[CONSOLE_MAX_ROWS];
+
+static struct graphics_color palette[16] = {
+	{0, 0, 0}, {0, 0, 170}, {0, 170, 0}, {0, 170, 170},
+	{170, 0, 0}, {170, 0, 170}, {170, 85, 0}, {170, 170, 170},
+	{85, 85, 85}, {85, 85, 255}, {85, 255, 85}, {85, 255, 255},
+	{255, 85, 85}, {255, 85, 255}, {255, 255, 85}, {255, 255, 255},
+};
+
+static inline struct console_cell *console_cell( struct console *d, int x, int y )
+{
+	return &d->cells[y * d->xsize + x];
+}
+
+static void console_free_grids( struct console *d )
+{
+	if(d == &console_root) return;
+	if(d->cells) kfree(d->cells);
+	if(d->shown) kfree(d->shown);
+	if(d->dirty) kfree(d->dirty);
+	d->cells = d->shown = 0;
+	d->dirty = 0;
+}
+
+/* Size the grids to the graphics, blank them, and clear the screen to match. */
+
+static void console_clear( struct console *d )
+{
+	int xsize = graphics_width(d->gx) / 8;
+	int ysize = graphics_height(d->gx) / 8;
+	int i;
+
+	if(d == &console_root) {
+		xsize = MIN(xsize, CONSOLE_MAX_COLUMNS);
+		ysize = MIN(ysize, CONSOLE_MAX_ROWS);
+	} else if(!d->cells || xsize != d->xsize || ysize != d->ysize) {
+		console_free_grids(d);
+		d->cells = kmalloc(xsize * ysize * sizeof(struct console_cell));
+		d->shown = kmalloc(xsize * ysize * sizeof(struct console_cell));
+		d->dirty = kmalloc(ysize);
+		if(!d->cells || !d->shown || !d->dirty) {
+			console_free_grids(d);
+			xsize = ysize = 0;
+		}
+	}
+
+	d->xpos = d->ypos = 0;
+	d->xsize = xsize;
+	d->ysize = ysize;
+	d->attr = CONSOLE_ATTR_DEFAULT;
+	d->cursor_x = d->cursor_y = -1;
+
+	for(i = 0; i < xsize * ysize; i++) {
+		d->cells[i].c = ' ';
+		d->cells[i].attr = d->attr;
+		d->shown[i] = d->cells[i];
+	}
+	for(i = 0; i < ysize; i++) {
+		d->dirty[i] = 0;
+	}
+
+	graphics_fgcolor(d->gx, palette[d->attr & 0xf]);
+	graphics_bgcolor(d->gx, palette[d->attr >> 4]);
+	graphics_clear(d->gx, 0, 0, graphics_width(d->gx), graphics_height(d->gx));
+}
+
+/* Move the grid up one row and blank the bottom row. */
+
+static void console_scroll( struct console *d )
+{
+	int i, n = d->xsize * (d->ysize - 1);
+
+	/* memcpy copies forward, so moving cells down in memory is safe. */
+	memcpy(d->cells, d->cells + d->xsize, n * sizeof(struct console_cell));
+	for(i = n; i < n + d->xsize; i++) {
+		d->cells[i].c = ' ';
+		d->cells[i].attr = d->attr;
+	}
+	for(i = 0; i < d->ysize; i++) {
+		d->dirty[i] = 1;
+	}
+}
+
+/* Draw the cursor glyph, remembering that the cell under it no longer matches. */
+
+static void console_cursor( struct console *d )
+{
+	if(d->xpos >= d->xsize || d->ypos >= d->ysize) return;
+
+	graphics_fgcolor(d->gx, palette[d->attr & 0xf]);
+	graphics_bgcolor(d->gx, palette[d->attr >> 4]);
+	graphics_char(d->gx, d->xpos * 8, d->ypos * 8, '_');
+	d->shown[d->ypos * d->xsize + d->xpos].attr = CONSOLE_ATTR_INVALID;
+	d->cursor_x = d->xpos;
+	d->cursor_y = d->ypos;
+}
+
+/* Repaint the cells of dirty rows that differ from what was drawn, in runs of one color. */
+
+static void console_flush( struct console *d )
+{
+	char text[64];
+	int x, y, n;
+
+	if(d->cursor_y >= 0) {
+		d->dirty[d->cursor_y] = 1;
+		d->cursor_x = d->cursor_y = -1;
+	}
+
+	for(y = 0; y < d->ysize; y++) {
+		if(!d->dirty[y]) continue;
+		d->dirty[y] = 0;
+
+		struct console_cell *cells = console_cell(d, 0, y);
+		struct console_cell *shown = &d->shown[y * d->xsize];
+
+		x = 0;
+		while(x < d->xsize) {
+			if(cells[x].c == shown[x].c && cells[x].attr == shown[x].attr) {
+				x++;
+				continue;
+			}
+
+			uint8_t attr = cells[x].attr;
+			int start = x;
+			for(n = 0; x < d->xsize && n < (int) sizeof(text); n++, x++) {
+				if(cells[x].attr != attr) break;
+				if(cells[x].c == shown[x].c && shown[x].attr == attr) break;
+				text[n] = cells[x].c;
+				shown[x] = cells[x];
+			}
+
+			graphics_fgcolor(d->gx, palette[attr & 0xf]);
+			graphics_bgcolor(d->gx, palette[attr >> 4]);
+			graphics_string(d->gx, start * 8, y * 8, text, n);
+		}
+	}
+
+	console_cursor(d);
+}
 
 struct console * console_create_root()
 {
 	console_root.window = window_create_root();
 	console_root.gx = window_graphics(console_root.window);
+	console_root.cells = root_cells;
+	console_root.shown = root_shown;
+	console_root.dirty = root_dirty;
 	console_reset(&console_root);
 	console_putstring(&console_root,"\nconsole: initialized\n");
 	return &console_root;
@@ -38,19 +208,26 @@ struct console * console_create_root()
 void console_reset( struct console *d )
 {
 	if(!d || !d->gx) return;
-	d->xpos = d->ypos = 0;
-	d->xsize = graphics_width(d->gx) / 8;
-	d->ysize = graphics_height(d->gx) / 8;
 	d->onoff = 0;
-	graphics_fgcolor(d->gx, fgcolor);
-	graphics_bgcolor(d->gx, bgcolor);
-	graphics_clear(d->gx, 0, 0, graphics_width(d->gx), graphics_height(d->gx));
+	console_clear(d);
+	window_update(d->window);
 }
 
 void console_heartbeat( struct console *d )
 {
-	char c = d->onoff ? ' ' : '_';
-	graphics_char(d->gx, d->xpos * 8, d->ypos * 8, c );
+	if(d->xpos >= d->xsize || d->ypos >= d->ysize) return;
+
+	if(d->onoff) {
+		/* Put back the cell under the cursor. */
+		struct console_cell *c = console_cell(d, d->xpos, d->ypos);
+		graphics_fgcolor(d->gx, palette[c->attr & 0xf]);
+		graphics_bgcolor(d->gx, palette[c->attr >> 4]);
+		graphics_char(d->gx, d->xpos * 8, d->ypos * 8, c->c);
+		d->shown[d->ypos * d->xsize + d->xpos] = *c;
+		d->cursor_x = d->cursor_y = -1;
+	} else {
+		console_cursor(d);
+	}
 	d->onoff = !d->onoff;
 }
 
@@ -76,9 +253,8 @@ int console_post( struct console *c, const char *data, int size )
 
 int console_write( struct console *d, const char *data, int size )
 {
-	graphics_char(d->gx, d->xpos * 8, d->ypos * 8, ' ');
-
 	int i;
+
 	for(i = 0; i < size; i++) {
 		char c = data[i];
 		switch (c) {
@@ -88,18 +264,18 @@ int console_write( struct console *d, const char *data, int size )
 			d->ypos++;
 			break;
 		case '\f':
-			d->xpos = d->ypos = 0;
-			d->xsize = graphics_width(d->gx) / 8;
-			d->ysize = graphics_height(d->gx) / 8;
-			graphics_fgcolor(d->gx, fgcolor);
-			graphics_bgcolor(d->gx, bgcolor);
-			graphics_clear(d->gx, 0, 0, graphics_width(d->gx), graphics_height(d->gx));
+			console_clear(d);
 			break;
 		case '\b':
 			d->xpos--;
 			break;
 		default:
-			graphics_char(d->gx, d->xpos * 8, d->ypos * 8, c);
+			if(d->xpos < d->xsize && d->ypos < d->ysize) {
+				struct console_cell *cell = console_cell(d, d->xpos, d->ypos);
+				cell->c = c;
+				cell->attr = d->attr;
+				d->dirty[d->ypos] = 1;
+			}
 			d->xpos++;
 			break;
 		}
@@ -107,6 +283,7 @@ int console_write( struct console *d, const char *data, int size )
 		if(d->xpos < 0) {
 			d->xpos = d->xsize - 1;
 			d->ypos--;
+			if(d->ypos < 0) d->xpos = d->ypos = 0;
 		}
 
 		if(d->xpos >= d->xsize) {
@@ -114,17 +291,14 @@ int console_write( struct console *d, const char *data, int size )
 			d->ypos++;
 		}
 
-		if(d->ypos >= d->ysize) {
-			d->xpos = d->ypos = 0;
-			d->xsize = graphics_width(d->gx) / 8;
-			d->ysize = graphics_height(d->gx) / 8;
-			graphics_fgcolor(d->gx, fgcolor);
-			graphics_bgcolor(d->gx, bgcolor);
-			graphics_clear(d->gx, 0, 0, graphics_width(d->gx), graphics_height(d->gx));
+		if(d->ypos >= d->ysize && d->ysize > 0) {
+			console_scroll(d);
+			d->ypos = d->ysize - 1;
 		}
 
 	}
-	graphics_char(d->gx, d->xpos * 8, d->ypos * 8, '_');
+	console_flush(d);
+	window_update(d->window);
 	return i;
 }
 
@@ -145,14 +319,13 @@ int console_read( struct console *c, char *data, int length )
 	return total;
 }
 
-int console_read_nonblock( struct console *c, char *data, int length, int *pressed)
+int console_read_nonblock( struct console *c, char *data, int length )
 {
 	int total=0;
 
 	struct event e;
 	while(length>0 && window_read_events_nonblock(c->window,&e,sizeof(e))) {
 		if(e.type==EVENT_KEY_DOWN) {
-			*pressed = 1;
 			*data = e.code;
 			length--;
 			total++;
@@ -186,6 +359,8 @@ void console_putstring( struct console *c, const char *str)
 struct console *console_create( struct window *w )
 {
 	struct console *c = kmalloc(sizeof(*c));
+	if(!c) return 0;
+	memset(c, 0, sizeof(*c));
 	c->window = window_addref(w);
 	c->gx = window_graphics(w);
 	c->refcount = 1;
@@ -206,6 +381,7 @@ void console_delete( struct console *c )
 	c->refcount--;
 	if(c->refcount==0) {
 		window_delete(c->window);
+		console_free_grids(c);
 		kfree(c);
 	}
 }
@@ -38,16 +38,6 @@ void event_queue_delete( struct event_queue *q )
 
 void event_queue_post( struct event_queue *q, struct event *e )
 {
-	/* If the event type is EVENT_KEY_UP, clear the queue */
-	if(e->type == EVENT_KEY_UP) {
-        q->head = 0;
-        q->tail = 0;
-        q->overflow_count = 0;
-        memset(q->buffer, 0, sizeof(q->buffer));
-        process_wakeup(&q->process_queue);
-        return; // Exit the function after clearing the queue
-    }
-
 	/* If ring buffer is full, return immediately. */
 	int next = (q->head+1) % EVENT_BUFFER_SIZE;
 	if(next==q->tail) {
@@ -14,6 +14,8 @@ See the file LICENSE for details.
 #include "bitmap.h"
 #include "string.h"
 #include "process.h"
+#include "clock.h"
+#include "vbe.h"
 
 #define FACTOR 256
 
@@ -24,11 +26,18 @@ struct graphics_clip {
 	uint32_t h;
 };
 
+struct graphics_ops;
+
 struct graphics {
 	struct bitmap *bitmap;
+	const struct graphics_ops *ops;
 	struct graphics_color fgcolor;
 	struct graphics_color bgcolor;
+	int textmode;
 	struct graphics_clip clip;
+	struct bitmap *bitmaps[GRAPHICS_BITMAP_HANDLES];
+	struct graphics *owner;		/* the graphics that owns the bitmap drawn into */
+	struct graphics_clip dirty;	/* area changed since graphics_take_damage, if owner */
 	struct graphics *parent;
 	int refcount;
 };
@@ -38,12 +47,396 @@ static struct graphics_color color_white = { 255, 255, 255, 0 };
 
 struct graphics graphics_root;
 
+/*
+The root graphics object may optionally render into a back buffer
+kept in system memory.  Each primitive that touches the back buffer
+records the rectangle that it changed, and graphics_present copies
+only those rectangles to the video buffer, as a burst of row copies.
+Nearby rectangles are merged as they are recorded, so that an object
+that is erased and redrawn in place costs a single copy.
+*/
+
+#define GRAPHICS_DAMAGE_MAX 32
+#define GRAPHICS_DAMAGE_SLACK 1024
+
+static struct bitmap *front_bitmap = 0;
+static struct bitmap *back_bitmap = 0;
+static struct graphics_clip damage[GRAPHICS_DAMAGE_MAX];
+static int damage_count = 0;
+
+/*
+If the adapter can flip between two pages of video memory, present
+copies the damage into the hidden page and then shows it, so that
+no frame is seen half drawn.  The hidden page was last brought up to
+date two presents ago, so the damage of the previous present is
+copied along with the current one.
+*/
+
+static struct bitmap flip_pages[2];
+static int flip_hidden = -1;
+static struct graphics_clip flip_damage[GRAPHICS_DAMAGE_MAX];
+static int flip_damage_count = 0;
+
+static inline uint32_t damage_area(struct graphics_clip *r)
+{
+	return r->w * r->h;
+}
+
+static inline struct graphics_clip damage_union(struct graphics_clip *a, struct graphics_clip *b)
+{
+	struct graphics_clip u;
+	u.x = MIN(a->x, b->x);
+	u.y = MIN(a->y, b->y);
+	u.w = MAX(a->x + a->w, b->x + b->w) - u.x;
+	u.h = MAX(a->y + a->h, b->y + b->h) - u.y;
+	return u;
+}
+
+static void damage_add(struct graphics_clip r)
+{
+	int i, best;
+	uint32_t cost, best_cost;
+	struct graphics_clip u;
+
+	/* Absorb every existing rectangle that is cheap to merge with. */
+	i = 0;
+	while(i < damage_count) {
+		u = damage_union(&r, &damage[i]);
+		if(damage_area(&u) <= damage_area(&r) + damage_area(&damage[i]) + GRAPHICS_DAMAGE_SLACK) {
+			r = u;
+			damage[i] = damage[--damage_count];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	if(damage_count < GRAPHICS_DAMAGE_MAX) {
+		damage[damage_count++] = r;
+		return;
+	}
+
+	/* Out of slots: merge with the rectangle that grows the least. */
+	best = 0;
+	best_cost = 0xffffffff;
+	for(i = 0; i < damage_count; i++) {
+		u = damage_union(&r, &damage[i]);
+		cost = damage_area(&u) - damage_area(&damage[i]);
+		if(cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+	damage[best] = damage_union(&r, &damage[best]);
+}
+
+/*
+Record a changed region, given in absolute bitmap coordinates.
+Besides the damage list of the back buffer, the owner of each bitmap
+keeps the bounding box of everything drawn into it, for the window
+compositor to collect with graphics_take_damage.
+*/
+
+static void graphics_damage(struct graphics *g, int x, int y, int w, int h)
+{
+	struct graphics_clip r;
+	struct graphics *o = g->owner;
+
+	if(x < 0) { w += x; x = 0; }
+	if(y < 0) { h += y; y = 0; }
+	w = MIN((int) g->bitmap->width - x, w);
+	h = MIN((int) g->bitmap->height - y, h);
+	if(w <= 0 || h <= 0) return;
+
+	r.x = x;
+	r.y = y;
+	r.w = w;
+	r.h = h;
+
+	if(o) o->dirty = o->dirty.w ? damage_union(&o->dirty, &r) : r;
+	if(back_bitmap && g->bitmap == back_bitmap) damage_add(r);
+}
+
+static inline void graphics_copy_row(uint8_t *d, const uint8_t *s, int length)
+{
+	int words = length / 4;
+	int bytes = length % 4;
+	asm volatile("rep movsl" : "+D"(d), "+S"(s), "+c"(words) : : "memory");
+	asm volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(bytes) : : "memory");
+}
+
+/*
+Fill n 24-bit pixels of one color starting at d.  The first few
+pixels are stored a byte at a time until d is 4-byte aligned, then
+four pixels at a time as three 32-bit words holding the repeating
+B,G,R pattern, and the rest a byte at a time again.
+*/
+
+static void graphics_fill_span_24(uint8_t *d, int n, struct graphics_color c)
+{
+	while(n > 0 && ((uint32_t) d & 3)) {
+		d[0] = c.b;
+		d[1] = c.g;
+		d[2] = c.r;
+		d += 3;
+		n--;
+	}
+
+	uint32_t w0 = c.b | c.g << 8 | c.r << 16 | c.b << 24;
+	uint32_t w1 = c.g | c.r << 8 | c.b << 16 | c.g << 24;
+	uint32_t w2 = c.r | c.b << 8 | c.g << 16 | c.r << 24;
+	uint32_t *q = (uint32_t *) d;
+
+	while(n >= 4) {
+		q[0] = w0;
+		q[1] = w1;
+		q[2] = w2;
+		q += 3;
+		n -= 4;
+	}
+
+	d = (uint8_t *) q;
+	while(n > 0) {
+		d[0] = c.b;
+		d[1] = c.g;
+		d[2] = c.r;
+		d += 3;
+		n--;
+	}
+}
+
+/* Fill n 32-bit pixels of one color starting at d, one store each. */
+
+static void graphics_fill_span_32(uint8_t *d, int n, struct graphics_color c)
+{
+	uint32_t p = c.b | c.g << 8 | c.r << 16;
+	asm volatile("rep stosl" : "+D"(d), "+c"(n) : "a"(p) : "memory");
+}
+
+static inline int is_key(const uint8_t *p, const struct graphics_color *key)
+{
+	return p[0] == key->b && p[1] == key->g && p[2] == key->r;
+}
+
+/* Copy one row of 24-bit pixels, as runs between the pixels that match the key. */
+
+static void graphics_copy_keyed_24(uint8_t *d, const uint8_t *s, int w, const struct graphics_color *key)
+{
+	int i = 0, start;
+
+	while(i < w) {
+		while(i < w && is_key(s + i * 3, key)) i++;
+		start = i;
+		while(i < w && !is_key(s + i * 3, key)) i++;
+		if(i > start) graphics_copy_row(d + start * 3, s + start * 3, (i - start) * 3);
+	}
+}
+
+/* The same for 32-bit pixels, comparing whole words with the X byte masked off. */
+
+static void graphics_copy_keyed_32(uint8_t *d, const uint8_t *s, int w, const struct graphics_color *key)
+{
+	const uint32_t *p = (const uint32_t *) s;
+	uint32_t k = key->b | key->g << 8 | key->r << 16;
+	int i = 0, start;
+
+	while(i < w) {
+		while(i < w && (p[i] & 0xffffff) == k) i++;
+		start = i;
+		while(i < w && (p[i] & 0xffffff) != k) i++;
+		if(i > start) graphics_copy_row(d + start * 4, s + start * 4, (i - start) * 4);
+	}
+}
+
+/*
+Expand n bits of a one bit per pixel font, starting at bit *b of data,
+into a row of foreground and background pixels at d.  Returns the
+data pointer advanced past the bits consumed.
+*/
+
+static const uint8_t *graphics_glyph_row_24(uint8_t *d, const uint8_t *data, int *b, int n, struct graphics_color fg, struct graphics_color bg)
+{
+	int i;
+	for(i = 0; i < n; i++) {
+		struct graphics_color c = ((*data << *b) & 0x80) ? fg : bg;
+		d[0] = c.b;
+		d[1] = c.g;
+		d[2] = c.r;
+		d += 3;
+		if(++*b == 8) {
+			data++;
+			*b = 0;
+		}
+	}
+	return data;
+}
+
+static const uint8_t *graphics_glyph_row_32(uint8_t *d, const uint8_t *data, int *b, int n, struct graphics_color fg, struct graphics_color bg)
+{
+	uint32_t f = fg.b | fg.g << 8 | fg.r << 16;
+	uint32_t k = bg.b | bg.g << 8 | bg.r << 16;
+	uint32_t *q = (uint32_t *) d;
+	int i;
+	for(i = 0; i < n; i++) {
+		q[i] = ((*data << *b) & 0x80) ? f : k;
+		if(++*b == 8) {
+			data++;
+			*b = 0;
+		}
+	}
+	return data;
+}
+
+/*
+Each row of a font glyph is one byte, so every row the font can
+contain is expanded once at boot into a mask with all bits of a pixel
+set where the glyph is drawn.  An opaque glyph row is then a handful of
+whole-word stores, selecting between foreground and background by mask.
+*/
+
+static uint32_t glyph_mask_24[256][6];
+static uint32_t glyph_mask_32[256][8];
+
+static void graphics_glyph_init()
+{
+	int v, i;
+
+	for(v = 0; v < 256; v++) {
+		uint8_t *m = (uint8_t *) glyph_mask_24[v];
+		for(i = 0; i < 8; i++) {
+			uint8_t set = (v & (0x80 >> i)) ? 0xff : 0;
+			m[i * 3] = m[i * 3 + 1] = m[i * 3 + 2] = set;
+			glyph_mask_32[v][i] = set ? 0xffffffff : 0;
+		}
+	}
+}
+
+static void graphics_glyph_opaque_24(uint8_t *d, uint32_t pitch, const uint8_t *rows, struct graphics_color fg, struct graphics_color bg)
+{
+	/* Eight pixels are six words, repeating the three word B,G,R pattern. */
+	uint32_t k[3], x[3];
+	int i, j;
+
+	k[0] = bg.b | bg.g << 8 | bg.r << 16 | bg.b << 24;
+	k[1] = bg.g | bg.r << 8 | bg.b << 16 | bg.g << 24;
+	k[2] = bg.r | bg.b << 8 | bg.g << 16 | bg.r << 24;
+	x[0] = k[0] ^ (fg.b | fg.g << 8 | fg.r << 16 | fg.b << 24);
+	x[1] = k[1] ^ (fg.g | fg.r << 8 | fg.b << 16 | fg.g << 24);
+	x[2] = k[2] ^ (fg.r | fg.b << 8 | fg.g << 16 | fg.r << 24);
+
+	for(j = 0; j < FONT_HEIGHT; j++) {
+		const uint32_t *m = glyph_mask_24[rows[j]];
+		uint32_t *q = (uint32_t *) d;
+		for(i = 0; i < 6; i++) {
+			q[i] = k[i % 3] ^ (x[i % 3] & m[i]);
+		}
+		d += pitch;
+	}
+}
+
+static void graphics_glyph_opaque_32(uint8_t *d, uint32_t pitch, const uint8_t *rows, struct graphics_color fg, struct graphics_color bg)
+{
+	uint32_t k = bg.b | bg.g << 8 | bg.r << 16;
+	uint32_t x = k ^ (fg.b | fg.g << 8 | fg.r << 16);
+	int i, j;
+
+	for(j = 0; j < FONT_HEIGHT; j++) {
+		const uint32_t *m = glyph_mask_32[rows[j]];
+		uint32_t *q = (uint32_t *) d;
+		for(i = 0; i < 8; i++) {
+			q[i] = k ^ (x & m[i]);
+		}
+		d += pitch;
+	}
+}
+
+/* Transparent glyphs store only the foreground pixels and never read the target. */
+
+static void graphics_glyph_transparent_24(uint8_t *d, uint32_t pitch, const uint8_t *rows, struct graphics_color fg, struct graphics_color bg)
+{
+	int i, j;
+
+	for(j = 0; j < FONT_HEIGHT; j++) {
+		uint8_t bits = rows[j];
+		for(i = 0; bits; i++, bits <<= 1) {
+			if(bits & 0x80) {
+				d[i * 3] = fg.b;
+				d[i * 3 + 1] = fg.g;
+				d[i * 3 + 2] = fg.r;
+			}
+		}
+		d += pitch;
+	}
+}
+
+static void graphics_glyph_transparent_32(uint8_t *d, uint32_t pitch, const uint8_t *rows, struct graphics_color fg, struct graphics_color bg)
+{
+	uint32_t f = fg.b | fg.g << 8 | fg.r << 16;
+	int i, j;
+
+	for(j = 0; j < FONT_HEIGHT; j++) {
+		uint32_t *q = (uint32_t *) d;
+		uint8_t bits = rows[j];
+		for(i = 0; bits; i++, bits <<= 1) {
+			if(bits & 0x80) q[i] = f;
+		}
+		d += pitch;
+	}
+}
+
+/*
+Raster kernels specialized for each pixel format.  They are chosen
+once when a graphics object is created, so the inner loops never
+look at the format.  Alpha blending still goes through plot_pixel.
+*/
+
+struct graphics_ops {
+	int bpp;
+	void (*fill)(uint8_t *d, int n, struct graphics_color c);
+	void (*copy_keyed)(uint8_t *d, const uint8_t *s, int w, const struct graphics_color *key);
+	const uint8_t *(*glyph_row)(uint8_t *d, const uint8_t *data, int *b, int n, struct graphics_color fg, struct graphics_color bg);
+	void (*glyph[2])(uint8_t *d, uint32_t pitch, const uint8_t *rows, struct graphics_color fg, struct graphics_color bg);
+};
+
+static const struct graphics_ops graphics_ops_24 = {
+	3, graphics_fill_span_24, graphics_copy_keyed_24, graphics_glyph_row_24,
+	{ graphics_glyph_opaque_24, graphics_glyph_transparent_24 }
+};
+
+static const struct graphics_ops graphics_ops_32 = {
+	4, graphics_fill_span_32, graphics_copy_keyed_32, graphics_glyph_row_32,
+	{ graphics_glyph_opaque_32, graphics_glyph_transparent_32 }
+};
+
+static const struct graphics_ops *graphics_ops_select(int format)
+{
+	switch (format) {
+	case BITMAP_FORMAT_RGB:
+		return &graphics_ops_24;
+	case BITMAP_FORMAT_XRGB:
+		return &graphics_ops_32;
+	default:
+		return 0;
+	}
+}
+
+static inline uint8_t *pixel_address(struct bitmap *b, int x, int y)
+{
+	return b->data + y * b->pitch + x * BITMAP_BYTES_PER_PIXEL(b->format);
+}
+
 struct graphics *graphics_create_root()
 {
 	struct graphics *g = &graphics_root;
 	g->bitmap = bitmap_create_root();
+	g->ops = graphics_ops_select(g->bitmap->format);
 	g->fgcolor = color_white;
 	g->bgcolor = color_black;
+	g->textmode = GRAPHICS_TEXT_OPAQUE;
+	memset(g->bitmaps, 0, sizeof(g->bitmaps));
+	graphics_glyph_init();
+	g->owner = g;
+	g->dirty.w = g->dirty.h = 0;
 	g->clip.x = 0;
 	g->clip.y = 0;
 	g->clip.w = g->bitmap->width;
@@ -53,6 +446,37 @@ struct graphics *graphics_create_root()
 	return g;
 }
 
+/*
+A graphics object that draws into a bitmap in memory instead of
+the screen, used to render sprites once for graphics_blit.
+The bitmap is owned by the caller and must outlive the graphics.
+*/
+
+struct graphics *graphics_create_bitmap(struct bitmap *b)
+{
+	const struct graphics_ops *ops = graphics_ops_select(b->format);
+	if(!ops) return 0;
+
+	struct graphics *g = kmalloc(sizeof(*g));
+	if(!g) return 0;
+
+	g->bitmap = b;
+	g->ops = ops;
+	g->fgcolor = color_white;
+	g->bgcolor = color_black;
+	g->textmode = GRAPHICS_TEXT_OPAQUE;
+	memset(g->bitmaps, 0, sizeof(g->bitmaps));
+	g->owner = g;
+	g->dirty.w = g->dirty.h = 0;
+	g->clip.x = 0;
+	g->clip.y = 0;
+	g->clip.w = b->width;
+	g->clip.h = b->height;
+	g->parent = 0;
+	g->refcount = 1;
+	return g;
+}
+
 struct graphics *graphics_create(struct graphics *parent )
 {
 	struct graphics *g = kmalloc(sizeof(*g));
@@ -60,6 +484,17 @@ struct graphics *graphics_create(struct graphics *parent )
 
 	memcpy(g, parent, sizeof(*g));
 
+	/* Uploaded bitmaps belong to the graphics they were uploaded to. */
+	memset(g->bitmaps, 0, sizeof(g->bitmaps));
+
+	/*
+	Children always draw to the visible buffer; only the root is presented.
+	When flipping, neither page stays visible, so they draw to the back
+	buffer too and appear with the next present.
+	*/
+	if(back_bitmap && g->bitmap == back_bitmap && flip_hidden < 0)
+		g->bitmap = front_bitmap;
+
 	g->parent = graphics_addref(parent);
 	g->refcount = 1;
 
@@ -81,74 +516,48 @@ void graphics_delete( struct graphics *g )
 
 	g->refcount--;
 	if(g->refcount==0) {
+		int i;
+		for(i = 0; i < GRAPHICS_BITMAP_HANDLES; i++) {
+			if(g->bitmaps[i]) bitmap_delete(g->bitmaps[i]);
+		}
 		graphics_delete(g->parent);
 		kfree(g);
 	}
 }
 
-#define ADVANCE(n) { cmd+=n; length-=n; }
+uint32_t graphics_width(struct graphics * g)
+{
+	return g->clip.w;
+}
 
-int graphics_write(struct graphics *g, int *cmd, int length )
+uint32_t graphics_height(struct graphics * g)
 {
-	struct graphics_color c;
+	return g->clip.h;
+}
 
-	while(length>0) {
-		switch (*cmd) {
-		case GRAPHICS_FGCOLOR:
-			c.r = cmd[1];
-			c.g = cmd[2];
-			c.b = cmd[3];
-			c.a = 0;
-			graphics_fgcolor(g, c);
-			ADVANCE(4)
-			break;
-		case GRAPHICS_BGCOLOR:
-			c.r = cmd[1];
-			c.g = cmd[2];
-			c.b = cmd[3];
-			c.a = 0;
-			graphics_bgcolor(g, c);
-			ADVANCE(4)
-			break;
-		case GRAPHICS_RECT:
-			graphics_rect(g, cmd[1], cmd[2], cmd[3], cmd[4] , c);
-			ADVANCE(5)
-			break;
-		case GRAPHICS_CLEAR:
-			graphics_clear(g, cmd[1], cmd[2], cmd[3], cmd[4]);
-			ADVANCE(5)
-			break;
-		case GRAPHICS_LINE:
-			graphics_line(g, cmd[1], cmd[2], cmd[3], cmd[4]);
-			ADVANCE(5)
-			break;
-		case GRAPHICS_TEXT: {
-			int x = cmd[1];
-			int y = cmd[2];
-			int strlength = cmd[3];
-			int i;
-			for(i = 0; i<strlength; i++) {
-				graphics_char(g,x+i*FONT_WIDTH,y,cmd[4+i]);
-			}
-			ADVANCE(4+strlength)
-			break;
-		}
-		default:
-			return KERROR_INVALID_REQUEST;
-			break;
-		}
-	}
-	return 0;
+int graphics_format(struct graphics *g)
+{
+	return g->bitmap->format;
 }
 
-uint32_t graphics_width(struct graphics * g)
+void graphics_own_damage(struct graphics *g)
 {
-	return g->clip.w;
+	g->owner = g;
+	g->dirty.w = g->dirty.h = 0;
 }
 
-uint32_t graphics_height(struct graphics * g)
+int graphics_take_damage(struct graphics *g, struct graphics_rect *r)
 {
-	return g->clip.h;
+	struct graphics *o = g->owner;
+
+	if(!o || !o->dirty.w) return 0;
+
+	r->x = o->dirty.x;
+	r->y = o->dirty.y;
+	r->w = o->dirty.w;
+	r->h = o->dirty.h;
+	o->dirty.w = o->dirty.h = 0;
+	return 1;
 }
 
 void graphics_fgcolor(struct graphics *g, struct graphics_color c)
@@ -161,6 +570,11 @@ void graphics_bgcolor(struct graphics *g, struct graphics_color c)
 	g->bgcolor = c;
 }
 
+void graphics_textmode(struct graphics *g, int mode)
+{
+	g->textmode = mode;
+}
+
 int graphics_clip(struct graphics *g, int x, int y, int w, int h)
 {
 	// Clip values may not be negative
@@ -186,7 +600,7 @@ int graphics_clip(struct graphics *g, int x, int y, int w, int h)
 
 static inline void plot_pixel(struct bitmap *b, int x, int y, struct graphics_color c)
 {
-	uint8_t *v = b->data + (b->width * y + x) * 3;
+	uint8_t *v = pixel_address(b, x, y);
 	if(c.a == 0) {
 		v[2] = c.r;
 		v[1] = c.g;
@@ -211,144 +625,190 @@ static void graphics_rect_internal(struct graphics *g, int x, int y, int w, int
 
 	w = MIN(g->clip.w - x, w);
 	h = MIN(g->clip.h - y, h);
+	if(w <= 0 || h <= 0) return;
 
 	x += g->clip.x;
 	y += g->clip.y;
 
-	for(j = 0; j < h; j++) {
-		for(i = 0; i < w; i++) {
-			plot_pixel(g->bitmap, x + i, y + j,c);
+	graphics_damage(g, x, y, w, h);
+
+	if(c.a != 0) {
+		for(j = 0; j < h; j++) {
+			for(i = 0; i < w; i++) {
+				plot_pixel(g->bitmap, x + i, y + j,c);
+			}
 		}
+		return;
+	}
+
+	uint32_t stride = g->bitmap->pitch;
+	uint8_t *row = pixel_address(g->bitmap, x, y);
+
+	/* Whole rows without padding are contiguous, so they are filled as one span. */
+	if(w == g->bitmap->width && stride == w * g->ops->bpp) {
+		g->ops->fill(row, w * h, c);
+		return;
+	}
+
+	for(j = 0; j < h; j++) {
+		g->ops->fill(row, w, c);
+		row += stride;
 	}
 }
 
-#define ABS(n) (((n) < 0) ? -(n) : (n)) /* Absolute function */
+/*
+Fill the span x1..x2 of row y, both inclusive and relative to the clip,
+cut to the clip region.  Damage is recorded by the caller.
+*/
 
-float sqrt2(float x)
+static void graphics_span_internal(struct graphics *g, int x1, int x2, int y, struct graphics_color c)
 {
-    float y = 1.0;
-    while (ABS(x/y - y) > 0.001 /*Tolerance*/)
-    {
-        y=(y+x/y)/2.0;
-    }
-    return y;
+	int i;
+
+	if(y < 0 || y >= (int) g->clip.h) return;
+	if(x1 < 0) x1 = 0;
+	if(x2 >= (int) g->clip.w) x2 = g->clip.w - 1;
+	if(x1 > x2) return;
+
+	x1 += g->clip.x;
+	x2 += g->clip.x;
+	y += g->clip.y;
+
+	if(c.a != 0) {
+		for(i = x1; i <= x2; i++) {
+			plot_pixel(g->bitmap, i, y, c);
+		}
+		return;
+	}
+
+	g->ops->fill(pixel_address(g->bitmap, x1, y), x2 - x1 + 1, c);
 }
 
+/*
+Filled circle by the integer midpoint method.  Walking one octant
+gives the half width of every row, and each row is filled exactly
+once as a single span: rows y +- dy as dy steps, and rows y +- dx
+just before dx shrinks, which is when that row is widest.
+*/
+
 static void graphics_circ_internal(struct graphics *g, int x, int y, int r, struct graphics_color c )
 {
-	int i, j;
+	int dx, dy, err;
+	int x1, y1, x2, y2;
 
-	if(x<0) { r+=x; x=0; }
-	if(y<0) { r+=y; y=0; }
+	if(r < 0) return;
 
-	if(x>g->clip.w || y>g->clip.h) return;
+	x1 = MAX(x - r, 0);
+	y1 = MAX(y - r, 0);
+	x2 = MIN(x + r, (int) g->clip.w - 1);
+	y2 = MIN(y + r, (int) g->clip.h - 1);
+	if(x1 > x2 || y1 > y2) return;
 
-	r = MIN(g->clip.w - x, r);
-	r = MIN(g->clip.h - y, r);
+	graphics_damage(g, g->clip.x + x1, g->clip.y + y1, x2 - x1 + 1, y2 - y1 + 1);
 
-	x += g->clip.x;
-	y += g->clip.y;
+	dx = r;
+	dy = 0;
+	err = 1 - r;
 
-    float sinus = 0.70710678118;
-    //This is the distance on the axis from sin(90) to sin(45). 
-    int range = r/(2*sinus);
-    for(int i = r ; i >= range ; --i)
-    {
-        int j = sqrt2(r*r - i*i);
-        for(int k = -j ; k <= j ; k++)
-        {
-            //We draw all the 4 sides at the same time.
-            plot_pixel(g->bitmap, x-k,y+i, c);
-            plot_pixel(g->bitmap, x-k,y-i, c);
-            plot_pixel(g->bitmap, x+i,y+k, c);
-            plot_pixel(g->bitmap, x-i,y-k, c);
-        }
-    }
-    //To fill the circle we draw the circumscribed square.
-    range = r*sinus;
-    for(int i = x - range + 1 ; i < x + range ; i++)
-    {
-        for(int j = y - range + 1 ; j < y + range ; j++)
-        {
-            plot_pixel(g->bitmap, i, j, c);
-        }
-    }
+	while(dx >= dy) {
+		graphics_span_internal(g, x - dx, x + dx, y + dy, c);
+		if(dy != 0)
+			graphics_span_internal(g, x - dx, x + dx, y - dy, c);
+
+		if(err >= 0 && dx != dy) {
+			graphics_span_internal(g, x - dy, x + dy, y + dx, c);
+			graphics_span_internal(g, x - dy, x + dy, y - dx, c);
+		}
+
+		dy++;
+		if(err < 0) {
+			err += 2 * dy + 1;
+		} else {
+			dx--;
+			err += 2 * (dy - dx) + 1;
+		}
+	}
 }
 
 // Swap two bytes
 #define SWAP(x,y) do { (x)=(x)^(y); (y)=(x)^(y); (x)=(x)^(y); } while(0)
 
-// Horizontal line
-void lcd_hline(struct graphics *g, int x1, int x2, int y, struct graphics_color color) {
-	if(x1>=x2) SWAP(x1,x2);
-	for(;x1<=x2;x1++) plot_pixel(g->bitmap, x1, y, color);
+/*
+Step the two edges x_a and x_b of a triangle down rows ystart..yend,
+filling the span between them on each row.  Edges are 16.16 fixed
+point, given at row y and advanced by their slope once per row.
+Rows outside the clip are skipped by moving the edges directly.
+*/
+
+static void graphics_tri_rows(struct graphics *g, int ystart, int yend, int y, int32_t xa, int32_t sa, int32_t xb, int32_t sb, struct graphics_color c)
+{
+	int a, b;
+
+	if(ystart < 0) ystart = 0;
+	if(yend >= (int) g->clip.h) yend = g->clip.h - 1;
+	if(ystart > yend) return;
+
+	xa += sa * (ystart - y);
+	xb += sb * (ystart - y);
+
+	for(y = ystart; y <= yend; y++) {
+		a = (xa + 0x8000) >> 16;
+		b = (xb + 0x8000) >> 16;
+		if(a > b) SWAP(a, b);
+		graphics_span_internal(g, a, b, y, c);
+		xa += sa;
+		xb += sb;
+	}
 }
 
-// Fill a triangle - slope method
+/*
+Fill a triangle one scanline at a time.  The vertices are sorted by
+row, and the long edge 0-2 is stepped against edge 0-1 for the upper
+part and edge 1-2 for the lower part, all in 16.16 fixed point.
+*/
+
 void graphics_tri_internal(struct graphics *g, int x0, int y0,int x1, int y1, int x2, int y2, struct graphics_color color) {
- 	int a, b, y, last;
-  	// Sort coordinates by Y order (y2 >= y1 >= y0)
-  	if (y0 > y1) { SWAP(y0, y1); SWAP(x0, x1); }
-  	if (y1 > y2) { SWAP(y2, y1); SWAP(x2, x1); }
-  	if (y0 > y1) { SWAP(y0, y1); SWAP(x0, x1); }
-  
-  	if(y0 == y2) { // All on same line case
-    	a = b = x0;
-    	if(x1 < a)      a = x1;
-    	else if(x1 > b) b = x1;
-    	if(x2 < a)      a = x2;
-    	else if(x2 > b) b = x2;
-        lcd_hline(g, a, b, y0, color);
-        return;
-    }
-
-    double
-        dx01 = x1 - x0,
-        dy01 = y1 - y0,
-        dx02 = x2 - x0,
-        dy02 = y2 - y0,
-        dx12 = x2 - x1,
-        dy12 = y2 - y1;
-    double sa = 0, sb = 0;
-
-    // For upper part of triangle, find scanline crossings for segment
-    // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y
-    // is included here (and second loop will be skipped, avoiding a /
-    // error there), otherwise scanline y1 is skipped here and handle
-    // in the second loop...which also avoids a /0 error here if y0=y
-    // (flat-topped triangle)
-    if(y1 == y2) last = y1;   // Include y1 scanline
-    else         last = y1-1; // Skip it
-
-    for(y=y0; y<=last; y++) {
-        a   = x0 + sa / dy01;
-        b   = x0 + sb / dy02;
-        sa += dx01;
-        sb += dx02;
-        // longhand a = x0 + (x1 - x0) * (y - y0) / (y1 - y0)
-        //          b = x0 + (x2 - x0) * (y - y0) / (y2 - y0)
-        lcd_hline(g, a, b, y, color);
-    }
-
-    // For lower part of triangle, find scanline crossings for segment
-    // 0-2 and 1-2.  This loop is skipped if y1=y2
-    sa = dx12 * (y - y1);
-    sb = dx02 * (y - y0);
-    for(; y<=y2; y++) {
-        a   = x1 + sa / dy12;
-        b   = x0 + sb / dy02;
-        sa += dx12;
-        sb += dx02;
-        // longhand a = x1 + (x2 - x1) * (y - y1) / (y2 - y1)
-        //          b = x0 + (x2 - x0) * (y - y0) / (y2 - y0)
-        lcd_hline(g, a, b, y, color);
-    }
+	int a, b, last;
+	int32_t s02, s01, s12;
+
+	// Sort coordinates by Y order (y2 >= y1 >= y0)
+	if(y0 > y1) { SWAP(y0, y1); SWAP(x0, x1); }
+	if(y1 > y2) { SWAP(y2, y1); SWAP(x2, x1); }
+	if(y0 > y1) { SWAP(y0, y1); SWAP(x0, x1); }
+
+	a = MAX(MIN(x0, MIN(x1, x2)), 0);
+	b = MIN(MAX(x0, MAX(x1, x2)), (int) g->clip.w - 1);
+	if(a > b || y2 < 0 || y0 >= (int) g->clip.h) return;
+	graphics_damage(g, g->clip.x + a, g->clip.y + MAX(y0, 0), b - a + 1, MIN(y2, (int) g->clip.h - 1) - MAX(y0, 0) + 1);
+
+	if(y0 == y2) { // All on same line case
+		a = MIN(x0, MIN(x1, x2));
+		b = MAX(x0, MAX(x1, x2));
+		graphics_span_internal(g, a, b, y0, color);
+		return;
+	}
+
+	s02 = ((x2 - x0) << 16) / (y2 - y0);
+
+	// If y1=y2 (flat-bottomed triangle), the upper part includes row y1
+	// and there is no lower part; otherwise row y1 belongs to the lower part.
+	last = (y1 == y2) ? y1 : y1 - 1;
+
+	if(y1 > y0) {
+		s01 = ((x1 - x0) << 16) / (y1 - y0);
+		graphics_tri_rows(g, y0, last, y0, x0 << 16, s01, x0 << 16, s02, color);
+	}
+
+	if(y2 > y1) {
+		s12 = ((x2 - x1) << 16) / (y2 - y1);
+		graphics_tri_rows(g, y1, y2, y1, x1 << 16, s12, (x0 << 16) + s02 * (y1 - y0), s02, color);
+	}
 }
 
 struct graphics_color get_pixel_color(struct graphics *g, int x, int y)
 {
 	struct graphics_color c;
-	uint8_t *v = g->bitmap->data + (g->bitmap->width * y + x) * 3;
+	uint8_t *v = pixel_address(g->bitmap, x, y);
 	c.r = v[2];
 	c.g = v[1];
 	c.b = v[0];
@@ -486,6 +946,12 @@ void graphics_line(struct graphics *g, int x, int y, int w, int h)
 	// Adjust origin to clip region.
 	x += g->clip.x;
 	y += g->clip.y;
+
+	if(h >= 0) {
+		graphics_damage(g, x, y, w + 1, h + 1);
+	} else {
+		graphics_damage(g, x, y + h, w + 1, 1 - h);
+	}
 	
 	if(h>0) {
 		if(w==0) {
@@ -511,36 +977,163 @@ void graphics_line(struct graphics *g, int x, int y, int w, int h)
 void graphics_bitmap(struct graphics *g, int x, int y, int width, int height, uint8_t * data)
 {
 	int i, j, b;
-	int value;
+	int i0, i1, j0, j1;
+	int transparent = g->textmode == GRAPHICS_TEXT_TRANSPARENT;
+
+	/* Draw only columns i0..i1-1 and rows j0..j1-1, the part inside the clip. */
+	i0 = MAX(-x, 0);
+	j0 = MAX(-y, 0);
+	i1 = MIN((int) g->clip.w - x, width);
+	j1 = MIN((int) g->clip.h - y, height);
+	if(i0 >= i1 || j0 >= j1) return;
 
-	width = MIN(g->clip.w - x, width);
-	height = MIN(g->clip.h - y, height);
 	x += g->clip.x;
 	y += g->clip.y;
 
-	b = 0;
-
-	for(j = 0; j < height; j++) {
-		for(i = 0; i < width; i++) {
-			value = ((*data) << b) & 0x80;
-			if(value) {
-				plot_pixel(g->bitmap, x + i, y + j, g->fgcolor);
-			} else {
-				plot_pixel(g->bitmap, x + i, y + j, g->bgcolor);
-			}
-			b++;
-			if(b == 8) {
-				data++;
-				b = 0;
+	graphics_damage(g, x + i0, y + j0, i1 - i0, j1 - j0);
+
+	/* Translucent colors and transparent text go pixel by pixel. */
+	if(transparent || g->fgcolor.a != 0 || g->bgcolor.a != 0) {
+		for(j = j0; j < j1; j++) {
+			for(i = i0; i < i1; i++) {
+				b = j * width + i;
+				if((data[b / 8] << (b % 8)) & 0x80) {
+					plot_pixel(g->bitmap, x + i, y + j, g->fgcolor);
+				} else if(!transparent) {
+					plot_pixel(g->bitmap, x + i, y + j, g->bgcolor);
+				}
 			}
 		}
+		return;
+	}
+
+	uint8_t *row = pixel_address(g->bitmap, x + i0, y + j0);
+	for(j = j0; j < j1; j++) {
+		b = j * width + i0;
+		const uint8_t *bits = data + b / 8;
+		b %= 8;
+		g->ops->glyph_row(row, bits, &b, i1 - i0, g->fgcolor, g->bgcolor);
+		row += g->bitmap->pitch;
 	}
 }
 
+/* True if glyphs can go through the whole-row kernels with these colors. */
+
+static inline int graphics_glyph_fast(struct graphics *g)
+{
+	return g->fgcolor.a == 0 && (g->bgcolor.a == 0 || g->textmode == GRAPHICS_TEXT_TRANSPARENT);
+}
+
 void graphics_char(struct graphics *g, int x, int y, unsigned char c)
 {
 	uint32_t u = ((uint32_t) c) * FONT_WIDTH * FONT_HEIGHT / 8;
-	return graphics_bitmap(g, x, y, FONT_WIDTH, FONT_HEIGHT, &fontdata[u]);
+
+	if(!graphics_glyph_fast(g) || x < 0 || y < 0 || x + FONT_WIDTH > g->clip.w || y + FONT_HEIGHT > g->clip.h) {
+		graphics_bitmap(g, x, y, FONT_WIDTH, FONT_HEIGHT, &fontdata[u]);
+		return;
+	}
+
+	x += g->clip.x;
+	y += g->clip.y;
+	graphics_damage(g, x, y, FONT_WIDTH, FONT_HEIGHT);
+	g->ops->glyph[g->textmode](pixel_address(g->bitmap, x, y), g->bitmap->pitch, &fontdata[u], g->fgcolor, g->bgcolor);
+}
+
+/*
+Draw a run of characters left to right.  The characters that lie
+wholly inside the clip are drawn back to back by the glyph kernel
+with one damage record; only those cut by the clip take graphics_char.
+*/
+
+void graphics_string(struct graphics *g, int x, int y, const char *str, int length)
+{
+	int i, first, last;
+
+	if(length <= 0) return;
+
+	if(!graphics_glyph_fast(g) || y < 0 || y + FONT_HEIGHT > g->clip.h) {
+		for(i = 0; i < length; i++) {
+			graphics_char(g, x + i * FONT_WIDTH, y, str[i]);
+		}
+		return;
+	}
+
+	first = x < 0 ? (FONT_WIDTH - 1 - x) / FONT_WIDTH : 0;
+	last = x < (int) g->clip.w ? ((int) g->clip.w - x) / FONT_WIDTH : 0;
+	first = MIN(first, length);
+	last = MAX(MIN(last, length), first);
+
+	for(i = 0; i < first; i++) {
+		graphics_char(g, x + i * FONT_WIDTH, y, str[i]);
+	}
+	for(i = last; i < length && x + i * FONT_WIDTH < (int) g->clip.w; i++) {
+		graphics_char(g, x + i * FONT_WIDTH, y, str[i]);
+	}
+	if(first == last) return;
+
+	int ax = g->clip.x + x + first * FONT_WIDTH;
+	int ay = g->clip.y + y;
+	graphics_damage(g, ax, ay, (last - first) * FONT_WIDTH, FONT_HEIGHT);
+
+	uint8_t *d = pixel_address(g->bitmap, ax, ay);
+	uint32_t step = FONT_WIDTH * g->ops->bpp;
+	for(i = first; i < last; i++) {
+		uint32_t u = ((uint32_t) (unsigned char) str[i]) * FONT_WIDTH * FONT_HEIGHT / 8;
+		g->ops->glyph[g->textmode](d, g->bitmap->pitch, &fontdata[u], g->fgcolor, g->bgcolor);
+		d += step;
+	}
+}
+
+void graphics_blit(struct graphics *g, int x, int y, struct bitmap *b, const struct graphics_color *key)
+{
+	graphics_blit_rect(g, x, y, b, 0, 0, b->width, b->height, key);
+}
+
+void graphics_blit_rect(struct graphics *g, int x, int y, struct bitmap *b, int sx, int sy, int w, int h, const struct graphics_color *key)
+{
+	int i, j;
+	int bpp = BITMAP_BYTES_PER_PIXEL(b->format);
+
+	/* Keep the source area inside the bitmap. */
+	if(sx < 0) { x -= sx; w += sx; sx = 0; }
+	if(sy < 0) { y -= sy; h += sy; sy = 0; }
+	w = MIN((int) b->width - sx, w);
+	h = MIN((int) b->height - sy, h);
+
+	/* Clip on all sides, moving the source origin with the destination. */
+	if(x < 0) { sx -= x; w += x; x = 0; }
+	if(y < 0) { sy -= y; h += y; y = 0; }
+	w = MIN((int) g->clip.w - x, w);
+	h = MIN((int) g->clip.h - y, h);
+	if(w <= 0 || h <= 0) return;
+
+	x += g->clip.x;
+	y += g->clip.y;
+
+	graphics_damage(g, x, y, w, h);
+
+	uint32_t sstride = b->pitch;
+	uint32_t dstride = g->bitmap->pitch;
+	const uint8_t *s = pixel_address(b, sx, sy);
+	uint8_t *d = pixel_address(g->bitmap, x, y);
+
+	for(j = 0; j < h; j++) {
+		if(b->format != g->bitmap->format) {
+			/* Convert or blend one pixel at a time. */
+			for(i = 0; i < w; i++) {
+				const uint8_t *p = s + i * bpp;
+				if(key && is_key(p, key)) continue;
+				struct graphics_color c = { p[2], p[1], p[0], b->format == BITMAP_FORMAT_RGBA ? p[3] : 0 };
+				plot_pixel(g->bitmap, x + i, y + j, c);
+			}
+		} else if(key) {
+			g->ops->copy_keyed(d, s, w, key);
+		} else {
+			graphics_copy_row(d, s, w * bpp);
+		}
+		s += sstride;
+		d += dstride;
+	}
 }
 
 void graphics_scrollup(struct graphics *g, int x, int y, int w, int h, int dy)
@@ -555,9 +1148,523 @@ void graphics_scrollup(struct graphics *g, int x, int y, int w, int h, int dy)
 	if(dy > h)
 		dy = h;
 
+	graphics_damage(g, x, y, w, h);
+
 	for(j = 0; j < (h - dy); j++) {
-		memcpy(&g->bitmap->data[((y + j) * g->bitmap->width + x) * 3], &g->bitmap->data[((y + j + dy) * g->bitmap->width + x) * 3], w * 3);
+		memcpy(pixel_address(g->bitmap, x, y + j), pixel_address(g->bitmap, x, y + j + dy), w * g->ops->bpp);
 	}
 
 	graphics_clear(g, x, y + h - dy, w, dy);
 }
+
+/* Copy n bytes that may overlap, backwards when the target lies above the source. */
+
+static void graphics_move_row(uint8_t *d, const uint8_t *s, int n)
+{
+	if(d <= s || d >= s + n) {
+		graphics_copy_row(d, s, n);
+	} else {
+		while(n-- > 0) d[n] = s[n];
+	}
+}
+
+void graphics_copy_area(struct graphics *g, int sx, int sy, int w, int h, int dx, int dy)
+{
+	int j;
+
+	/* Clip the source and then the destination, moving the other corner along. */
+	if(sx < 0) { dx -= sx; w += sx; sx = 0; }
+	if(sy < 0) { dy -= sy; h += sy; sy = 0; }
+	if(dx < 0) { sx -= dx; w += dx; dx = 0; }
+	if(dy < 0) { sy -= dy; h += dy; dy = 0; }
+	w = MIN(w, MIN((int) g->clip.w - sx, (int) g->clip.w - dx));
+	h = MIN(h, MIN((int) g->clip.h - sy, (int) g->clip.h - dy));
+	if(w <= 0 || h <= 0) return;
+
+	sx += g->clip.x;
+	sy += g->clip.y;
+	dx += g->clip.x;
+	dy += g->clip.y;
+
+	graphics_damage(g, dx, dy, w, h);
+
+	uint32_t n = w * g->ops->bpp;
+
+	/* Moving down, copy the bottom row first so no source row is overwritten early. */
+	if(dy > sy) {
+		for(j = h - 1; j >= 0; j--) {
+			graphics_move_row(pixel_address(g->bitmap, dx, dy + j), pixel_address(g->bitmap, sx, sy + j), n);
+		}
+	} else {
+		for(j = 0; j < h; j++) {
+			graphics_move_row(pixel_address(g->bitmap, dx, dy + j), pixel_address(g->bitmap, sx, sy + j), n);
+		}
+	}
+}
+
+/*
+Measure the fill rate of graphics_rect on the current target, against
+plotting each pixel as graphics_rect used to, and print both in
+Mpixels/s.  Text is measured the same way against graphics_string.
+Overwrites the screen.
+*/
+
+void graphics_benchmark(struct graphics *g)
+{
+	static const int sizes[] = { 8, 64, 0 };	/* 0 means the whole screen */
+	struct graphics_color c = { 0x40, 0x80, 0xc0, 0 };
+	uint32_t slow[3], fast[3], pixels[3];
+	int i, j, k, n;
+
+	for(k = 0; k < 3; k++) {
+		int w = sizes[k] ? sizes[k] : (int) g->clip.w;
+		int h = sizes[k] ? sizes[k] : (int) g->clip.h;
+		int count = sizes[k] ? 2000 : 10;
+		pixels[k] = w * h * count;
+
+		uint32_t start = clock_tsc();
+		for(n = 0; n < count; n++) {
+			for(j = 0; j < h; j++) {
+				for(i = 0; i < w; i++) {
+					plot_pixel(g->bitmap, g->clip.x + i, g->clip.y + j, c);
+				}
+			}
+		}
+		slow[k] = clock_tsc_usec(clock_tsc() - start);
+
+		start = clock_tsc();
+		for(n = 0; n < count; n++) {
+			graphics_rect(g, 0, 0, w, h, c);
+		}
+		fast[k] = clock_tsc_usec(clock_tsc() - start);
+	}
+
+	/* Text: a screen of characters a pixel at a time, then as strings. */
+	static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789";
+	int len = sizeof(text) - 1;
+	int lines = g->clip.h / FONT_HEIGHT;
+	uint32_t chars = len * lines * 20;
+	uint32_t slow_text, fast_text;
+
+	uint32_t start = clock_tsc();
+	for(n = 0; n < 20; n++) {
+		for(j = 0; j < lines; j++) {
+			for(k = 0; k < len; k++) {
+				const uint8_t *rows = &fontdata[(uint8_t) text[k] * FONT_HEIGHT];
+				for(i = 0; i < FONT_WIDTH * FONT_HEIGHT; i++) {
+					plot_pixel(g->bitmap, g->clip.x + k * FONT_WIDTH + i % FONT_WIDTH, g->clip.y + j * FONT_HEIGHT + i / FONT_WIDTH, ((rows[i / FONT_WIDTH] << (i % FONT_WIDTH)) & 0x80) ? g->fgcolor : g->bgcolor);
+				}
+			}
+		}
+	}
+	slow_text = clock_tsc_usec(clock_tsc() - start);
+
+	start = clock_tsc();
+	for(n = 0; n < 20; n++) {
+		for(j = 0; j < lines; j++) {
+			graphics_string(g, 0, j * FONT_HEIGHT, text, len);
+		}
+	}
+	fast_text = clock_tsc_usec(clock_tsc() - start);
+
+	/* The fills covered the console, so print once they are done. */
+	graphics_clear(g, 0, 0, g->clip.w, g->clip.h);
+	for(k = 0; k < 3; k++) {
+		int w = sizes[k] ? sizes[k] : (int) g->clip.w;
+		int h = sizes[k] ? sizes[k] : (int) g->clip.h;
+		printf("graphics: %dx%d fill: %u Mpixels/s per pixel, %u Mpixels/s spans\n", w, h, pixels[k] / MAX(slow[k], 1), pixels[k] / MAX(fast[k], 1));
+	}
+	printf("graphics: text: %u Kchars/s per pixel, %u Kchars/s strings\n", chars * 1000 / MAX(slow_text, 1), chars * 1000 / MAX(fast_text, 1));
+}
+
+/*
+Fill the lower quarter of the screen a few times and return the
+rate in MB/s, which mostly depends on how the framebuffer is mapped.
+*/
+
+#define GRAPHICS_FILL_RATE_COUNT 8
+
+uint32_t graphics_fill_rate(struct graphics *g)
+{
+	int h = g->clip.h / 4;
+	int n;
+	uint32_t bytes = g->clip.w * h * g->ops->bpp * GRAPHICS_FILL_RATE_COUNT;
+
+	uint32_t start = clock_tsc();
+	for(n = 0; n < GRAPHICS_FILL_RATE_COUNT; n++) {
+		graphics_rect(g, 0, g->clip.h - h, g->clip.w, h, color_black);
+	}
+	uint32_t usec = clock_tsc_usec(clock_tsc() - start);
+
+	return bytes / MAX(usec, 1);
+}
+
+/* Copy the given rectangles of the back buffer to the same place in dst. */
+
+static void graphics_present_rects(struct bitmap *dst, const struct graphics_clip *rects, int count)
+{
+	int i, j;
+	int bpp = BITMAP_BYTES_PER_PIXEL(back_bitmap->format);
+
+	for(i = 0; i < count; i++) {
+		const struct graphics_clip *r = &rects[i];
+		uint8_t *s = pixel_address(back_bitmap, r->x, r->y);
+		uint8_t *d = pixel_address(dst, r->x, r->y);
+		for(j = 0; j < r->h; j++) {
+			graphics_copy_row(d, s, r->w * bpp);
+			s += back_bitmap->pitch;
+			d += dst->pitch;
+		}
+	}
+}
+
+int graphics_backbuffer_enable(struct graphics *g)
+{
+	// Only the root graphics object can be double buffered.
+	if(g != &graphics_root) return 0;
+	if(back_bitmap) return 1;
+
+	struct bitmap *b = bitmap_create(g->bitmap->width, g->bitmap->height, g->bitmap->format);
+	if(!b) return 0;
+
+	// Start from the current screen contents, so undamaged areas match.
+	uint32_t y;
+	for(y = 0; y < b->height; y++) {
+		graphics_copy_row(b->data + y * b->pitch, g->bitmap->data + y * g->bitmap->pitch, b->pitch);
+	}
+
+	front_bitmap = g->bitmap;
+	back_bitmap = b;
+	damage_count = 0;
+	g->bitmap = back_bitmap;
+
+	/* Existing children draw to the first page, which would not stay on show. */
+	if(video_pages > 1 && g->refcount > 1) {
+		printf("graphics: root already has children, presenting by copy\n");
+	} else if(video_pages > 1) {
+		struct graphics_clip all = { 0, 0, b->width, b->height };
+		flip_pages[0] = *front_bitmap;
+		flip_pages[1] = *front_bitmap;
+		flip_pages[1].data += front_bitmap->pitch * front_bitmap->height;
+		graphics_present_rects(&flip_pages[1], &all, 1);
+		flip_hidden = 1;
+		flip_damage_count = 0;
+	}
+
+	return 1;
+}
+
+void graphics_backbuffer_disable(struct graphics *g)
+{
+	if(g != &graphics_root || !back_bitmap) return;
+
+	graphics_present(g);
+
+	/* Leave the first page showing, as the rest of the kernel expects. */
+	if(flip_hidden == 0) {
+		struct graphics_clip all = { 0, 0, back_bitmap->width, back_bitmap->height };
+		graphics_present_rects(&flip_pages[0], &all, 1);
+		vbe_flip(0);
+	}
+	flip_hidden = -1;
+
+	g->bitmap = front_bitmap;
+	bitmap_delete(back_bitmap);
+	back_bitmap = 0;
+	front_bitmap = 0;
+}
+
+void graphics_present(struct graphics *g)
+{
+	if(!back_bitmap || g->bitmap != back_bitmap) return;
+
+	if(flip_hidden < 0) {
+		graphics_present_rects(front_bitmap, damage, damage_count);
+		damage_count = 0;
+		return;
+	}
+
+	/* Nothing changed, so the page on show is still current. */
+	if(damage_count == 0) return;
+
+	struct bitmap *hidden = &flip_pages[flip_hidden];
+	graphics_present_rects(hidden, flip_damage, flip_damage_count);
+	graphics_present_rects(hidden, damage, damage_count);
+	vbe_flip(flip_hidden);
+	flip_hidden = !flip_hidden;
+
+	memcpy(flip_damage, damage, damage_count * sizeof(damage[0]));
+	flip_damage_count = damage_count;
+	damage_count = 0;
+}
+
+/*
+A batch of gfxstream commands is checked completely before any of it
+is drawn, so a malformed batch has no effect.  Both passes walk the
+batch with graphics_decode, which unpacks the arguments of one command
+and locates its trailing data.  See kernel/gfxstream.h for the format.
+*/
+
+#define GRAPHICS_MAX_ARGS 6
+
+struct graphics_command {
+	int op;
+	int packed;
+	int args[GRAPHICS_MAX_ARGS];
+	const int *data;	/* characters, span pairs, or pixels */
+	int ndata;
+};
+
+static const uint8_t graphics_nargs[GRAPHICS_MAX_COMMAND] = {
+	[GRAPHICS_END] = 0,
+	[GRAPHICS_FGCOLOR] = 3,
+	[GRAPHICS_BGCOLOR] = 3,
+	[GRAPHICS_LINE] = 4,
+	[GRAPHICS_RECT] = 4,
+	[GRAPHICS_CLEAR] = 4,
+	[GRAPHICS_TEXT] = 3,
+	[GRAPHICS_TRI] = 6,
+	[GRAPHICS_CIRCLE] = 3,
+	[GRAPHICS_SPANS] = 2,
+	[GRAPHICS_COPY_AREA] = 6,
+	[GRAPHICS_UPLOAD] = 3,
+	[GRAPHICS_BLIT] = 4,
+};
+
+static inline char graphics_command_char(const struct graphics_command *c, int i)
+{
+	return c->packed ? c->data[i / 4] >> (8 * (i % 4)) : c->data[i];
+}
+
+static inline void graphics_command_span(const struct graphics_command *c, int i, int *x1, int *x2)
+{
+	if(c->packed) {
+		*x1 = (int16_t) c->data[i];
+		*x2 = (int16_t) (c->data[i] >> 16);
+	} else {
+		*x1 = c->data[2 * i];
+		*x2 = c->data[2 * i + 1];
+	}
+}
+
+/* Which arguments of each command are coordinates, sizes or radii, one bit each. */
+
+static const uint8_t graphics_coords[GRAPHICS_MAX_COMMAND] = {
+	[GRAPHICS_LINE] = 0x0f,
+	[GRAPHICS_RECT] = 0x0f,
+	[GRAPHICS_CLEAR] = 0x0f,
+	[GRAPHICS_TEXT] = 0x03,
+	[GRAPHICS_TRI] = 0x3f,
+	[GRAPHICS_CIRCLE] = 0x07,
+	[GRAPHICS_SPANS] = 0x01,
+	[GRAPHICS_COPY_AREA] = 0x3f,
+	[GRAPHICS_BLIT] = 0x06,
+};
+
+static inline int graphics_coord_valid(int v)
+{
+	return v >= -GRAPHICS_COORD_MAX && v <= GRAPHICS_COORD_MAX;
+}
+
+/* Decode the command at cmd and return the number of words it takes, or an error. */
+
+static int graphics_decode(const int *cmd, int length, struct graphics_command *c)
+{
+	int i, n, words, extra;
+
+	c->op = cmd[0] & ~GRAPHICS_PACKED;
+	c->packed = cmd[0] & GRAPHICS_PACKED;
+	if(c->op < 0 || c->op >= GRAPHICS_MAX_COMMAND) return KERROR_INVALID_REQUEST;
+
+	n = graphics_nargs[c->op];
+	words = 1 + (c->packed ? (n + 1) / 2 : n);
+	if(words > length) return KERROR_INVALID_REQUEST;
+
+	for(i = 0; i < n; i++) {
+		if(c->packed) {
+			c->args[i] = (int16_t) (cmd[1 + i / 2] >> (16 * (i % 2)));
+		} else {
+			c->args[i] = cmd[1 + i];
+		}
+		if((graphics_coords[c->op] >> i) & 1 && !graphics_coord_valid(c->args[i])) return KERROR_INVALID_REQUEST;
+	}
+
+	switch (c->op) {
+	case GRAPHICS_TEXT:
+		c->ndata = c->args[2];
+		if(c->ndata < 0 || c->ndata / 4 > length) return KERROR_INVALID_REQUEST;
+		extra = c->packed ? (c->ndata + 3) / 4 : c->ndata;
+		break;
+	case GRAPHICS_SPANS:
+		c->ndata = c->args[1];
+		if(c->ndata < 0 || c->ndata > length) return KERROR_INVALID_REQUEST;
+		extra = c->packed ? c->ndata : 2 * c->ndata;
+		break;
+	case GRAPHICS_UPLOAD:
+		if(c->args[0] < 0 || c->args[0] >= GRAPHICS_BITMAP_HANDLES) return KERROR_INVALID_REQUEST;
+		if(c->args[1] <= 0 || c->args[1] > GRAPHICS_BITMAP_MAX_SIZE) return KERROR_INVALID_REQUEST;
+		if(c->args[2] <= 0 || c->args[2] > GRAPHICS_BITMAP_MAX_SIZE) return KERROR_INVALID_REQUEST;
+		c->ndata = c->args[1] * c->args[2];
+		extra = c->ndata;
+		break;
+	case GRAPHICS_CIRCLE:
+		if(c->args[2] < 0) return KERROR_INVALID_REQUEST;
+		c->ndata = extra = 0;
+		break;
+	case GRAPHICS_BLIT:
+		if(c->args[0] < 0 || c->args[0] >= GRAPHICS_BITMAP_HANDLES) return KERROR_INVALID_REQUEST;
+		c->ndata = extra = 0;
+		break;
+	default:
+		c->ndata = extra = 0;
+		break;
+	}
+
+	if(extra > length - words) return KERROR_INVALID_REQUEST;
+	c->data = cmd + words;
+
+	if(c->op == GRAPHICS_SPANS) {
+		int x1, x2;
+		for(i = 0; i < c->ndata; i++) {
+			graphics_command_span(c, i, &x1, &x2);
+			if(!graphics_coord_valid(x1) || !graphics_coord_valid(x2)) return KERROR_INVALID_REQUEST;
+		}
+	}
+
+	return words + extra;
+}
+
+static void graphics_spans(struct graphics *g, const struct graphics_command *c)
+{
+	int i, x1, x2;
+	int y = c->args[0];
+	int left = g->clip.w, right = -1;
+
+	for(i = 0; i < c->ndata; i++) {
+		graphics_command_span(c, i, &x1, &x2);
+		if(x1 > x2) SWAP(x1, x2);
+		left = MIN(left, x1);
+		right = MAX(right, x2);
+		graphics_span_internal(g, x1, x2, y + i, g->fgcolor);
+	}
+
+	left = MAX(left, 0);
+	right = MIN(right, (int) g->clip.w - 1);
+	if(left <= right) graphics_damage(g, g->clip.x + left, g->clip.y + y, right - left + 1, c->ndata);
+}
+
+/* Keep a copy of the uploaded pixels in the format of g, so blits are row copies. */
+
+static void graphics_upload(struct graphics *g, const struct graphics_command *c)
+{
+	int h = c->args[0];
+	int width = c->args[1];
+	int height = c->args[2];
+	struct bitmap *b = g->bitmaps[h];
+	int i, j;
+
+	if(b && (b->width != width || b->height != height || b->format != g->bitmap->format)) {
+		bitmap_delete(b);
+		b = g->bitmaps[h] = 0;
+	}
+	if(!b) {
+		b = g->bitmaps[h] = bitmap_create(width, height, g->bitmap->format);
+		if(!b) return;
+	}
+
+	const int *p = c->data;
+	for(j = 0; j < height; j++) {
+		for(i = 0; i < width; i++, p++) {
+			uint8_t *v = pixel_address(b, i, j);
+			v[0] = *p;
+			v[1] = *p >> 8;
+			v[2] = *p >> 16;
+		}
+	}
+}
+
+static void graphics_execute(struct graphics *g, const struct graphics_command *c)
+{
+	const int *a = c->args;
+	struct graphics_color color;
+	char text[64];
+	int i, n;
+
+	switch (c->op) {
+	case GRAPHICS_FGCOLOR:
+	case GRAPHICS_BGCOLOR:
+		color.r = a[0];
+		color.g = a[1];
+		color.b = a[2];
+		color.a = 0;
+		if(c->op == GRAPHICS_FGCOLOR) {
+			graphics_fgcolor(g, color);
+		} else {
+			graphics_bgcolor(g, color);
+		}
+		break;
+	case GRAPHICS_RECT:
+		graphics_rect(g, a[0], a[1], a[2], a[3], g->fgcolor);
+		break;
+	case GRAPHICS_CLEAR:
+		graphics_clear(g, a[0], a[1], a[2], a[3]);
+		break;
+	case GRAPHICS_LINE:
+		graphics_line(g, a[0], a[1], a[2], a[3]);
+		break;
+	case GRAPHICS_TEXT:
+		/* Hand the characters to graphics_string in chunks. */
+		for(i = 0; i < c->ndata; i += n) {
+			for(n = 0; n < (int) sizeof(text) && i + n < c->ndata; n++) {
+				text[n] = graphics_command_char(c, i + n);
+			}
+			graphics_string(g, a[0] + i * FONT_WIDTH, a[1], text, n);
+		}
+		break;
+	case GRAPHICS_TRI:
+		graphics_tri(g, a[0], a[1], a[2], a[3], a[4], a[5], g->fgcolor);
+		break;
+	case GRAPHICS_CIRCLE:
+		graphics_circ(g, a[0], a[1], a[2], g->fgcolor);
+		break;
+	case GRAPHICS_SPANS:
+		graphics_spans(g, c);
+		break;
+	case GRAPHICS_COPY_AREA:
+		graphics_copy_area(g, a[0], a[1], a[2], a[3], a[4], a[5]);
+		break;
+	case GRAPHICS_UPLOAD:
+		graphics_upload(g, c);
+		break;
+	case GRAPHICS_BLIT:
+		if(g->bitmaps[a[0]]) graphics_blit(g, a[1], a[2], g->bitmaps[a[0]], a[3] ? &g->bgcolor : 0);
+		break;
+	}
+}
+
+int graphics_write(struct graphics *g, int *cmd, int length )
+{
+	struct graphics_command c;
+	int *p = cmd;
+	int left = length;
+	int n;
+
+	/* Validate the whole batch first. */
+	while(left > 0) {
+		n = graphics_decode(p, left, &c);
+		if(n < 0) return n;
+		if(c.op == GRAPHICS_END) break;
+		p += n;
+		left -= n;
+	}
+
+	while(length > 0) {
+		n = graphics_decode(cmd, length, &c);
+		if(c.op == GRAPHICS_END) break;
+		graphics_execute(g, &c);
+		cmd += n;
+		length -= n;
+	}
+
+	return 0;
+}
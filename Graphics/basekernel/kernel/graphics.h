@@ -17,29 +17,92 @@ struct graphics_color {
 	uint8_t a;
 };
 
+struct bitmap;
+
 extern struct graphics graphics_root;
 
 struct graphics *graphics_create_root();
+struct graphics *graphics_create_bitmap(struct bitmap *b);
 struct graphics *graphics_create(struct graphics *parent );
 struct graphics *graphics_addref(struct graphics *g );
 void graphics_delete(struct graphics *g);
 
 uint32_t graphics_width(struct graphics *g);
 uint32_t graphics_height(struct graphics *g);
+int graphics_format(struct graphics *g);
+
+/*
+Store in r the bounding box of everything drawn into the bitmap of g,
+in the coordinates of that bitmap, since the last call.  Returns zero
+if nothing was drawn.  Children share the damage of their parent.
+*/
+
+int graphics_take_damage(struct graphics *g, struct graphics_rect *r);
+
+/* Keep the damage drawn through g apart from that of its parent. */
+
+void graphics_own_damage(struct graphics *g);
+
 void graphics_fgcolor(struct graphics *g, struct graphics_color c);
 void graphics_bgcolor(struct graphics *g, struct graphics_color c);
 int  graphics_clip(struct graphics *g, int x, int y, int w, int h);
 
 void graphics_scrollup(struct graphics *g, int x, int y, int w, int h, int dy);
-float sqrt2(float x);
+void graphics_copy_area(struct graphics *g, int sx, int sy, int w, int h, int dx, int dy);
 struct graphics_color get_pixel_color(struct graphics *g, int x, int y);
 void graphics_tri(struct graphics *g, int x0, int y0,int x1, int y1, int x2, int y2, struct graphics_color c);
 void graphics_circ(struct graphics *g, int x, int y, int r, struct graphics_color c);
 void graphics_rect(struct graphics *g, int x, int y, int w, int h, struct graphics_color c);
 void graphics_clear(struct graphics *g, int x, int y, int w, int h);
 void graphics_line(struct graphics *g, int x, int y, int w, int h);
+/*
+Text is drawn from the 8x8 font.  In GRAPHICS_TEXT_OPAQUE mode (the
+default) each glyph cell is filled with the background color; in
+GRAPHICS_TEXT_TRANSPARENT mode only the foreground pixels are drawn.
+*/
+
+#define GRAPHICS_TEXT_OPAQUE      0
+#define GRAPHICS_TEXT_TRANSPARENT 1
+
+void graphics_textmode(struct graphics *g, int mode);
 void graphics_char(struct graphics *g, int x, int y, unsigned char c);
 void graphics_string(struct graphics *g, int x, int y, const char *str, int length );
 int graphics_write(struct graphics *g, int *cmd, int length );
 
+/*
+Copy a whole bitmap with its top left corner at x, y.  If key is
+not null, pixels of exactly that color are left out, so a sprite
+can be drawn once into a bitmap and then blitted over any background.
+The alpha byte of an RGBA bitmap is a transparency, as in plot_pixel.
+A bitmap in the same format as the target is copied row by row, so
+sprites should be created with graphics_format of the target.
+*/
+
+void graphics_blit(struct graphics *g, int x, int y, struct bitmap *b, const struct graphics_color *key);
+
+/* Copy only the w by h area of b at sx, sy, with its top left corner at x, y. */
+
+void graphics_blit_rect(struct graphics *g, int x, int y, struct bitmap *b, int sx, int sy, int w, int h, const struct graphics_color *key);
+
+/* Print the fill rate of graphics_rect in Mpixels/s, overwriting the screen. */
+
+void graphics_benchmark(struct graphics *g);
+
+/* Return the rate of filling the screen in MB/s, blanking its lower quarter. */
+
+uint32_t graphics_fill_rate(struct graphics *g);
+
+/*
+The root graphics object can render into a back buffer in system
+memory.  Drawing is then invisible until graphics_present copies
+the regions damaged since the last present to the video buffer.
+Pages are only flipped if the root has no children yet, because a
+child keeps drawing to the page it was created on; otherwise frames
+are presented by copy.
+*/
+
+int  graphics_backbuffer_enable(struct graphics *g);
+void graphics_backbuffer_disable(struct graphics *g);
+void graphics_present(struct graphics *g);
+
 #endif
@@ -12,6 +12,8 @@ See the file LICENSE for details.
 extern uint16_t video_xbytes;
 extern uint16_t video_xres;
 extern uint16_t video_yres;
+extern uint8_t video_bpp;
+extern uint8_t video_image_pages;
 extern uint8_t *video_buffer;
 
 extern uint16_t total_memory;
@@ -10,6 +10,7 @@ See the file LICENSE for details.
 #include "kernel/ascii.h"
 #include "kernelcore.h"
 #include "event_queue.h"
+#include "keyboard.h"
 
 #define KEYBOARD_PORT 0x60
 
@@ -47,6 +48,66 @@ static int ctrl_mode = 0;
 static int capslock_mode = 0;
 static int numlock_mode = 0;
 
+/*
+Besides the event queue, the keyboard keeps its own state for
+programs that poll it, such as the game: a bitmap of the keys that
+are held down, and a ring of every press and release.  Both are
+indexed by the unshifted character of the key, so that holding
+shift doesn't change which key is down.  The interrupt handler is
+the only writer of the ring head and the reader the only writer
+of the tail, so neither side needs a lock.
+*/
+
+#define KEYBOARD_RING_SIZE 64
+
+static uint32_t key_state[256 / 32];
+static struct keyboard_event key_ring[KEYBOARD_RING_SIZE];
+static volatile uint32_t key_ring_head = 0;
+static volatile uint32_t key_ring_tail = 0;
+static uint32_t key_ring_overflow = 0;
+
+/* INTERRUPT CONTEXT */
+
+static void keyboard_state_update( uint8_t key, int down )
+{
+	if(down) {
+		key_state[key / 32] |= 1u << (key % 32);
+	} else {
+		key_state[key / 32] &= ~(1u << (key % 32));
+	}
+
+	uint32_t head = key_ring_head;
+	if(head - key_ring_tail >= KEYBOARD_RING_SIZE) {
+		key_ring_overflow++;
+		return;
+	}
+	key_ring[head % KEYBOARD_RING_SIZE].key = key;
+	key_ring[head % KEYBOARD_RING_SIZE].down = down;
+	asm volatile("" : : : "memory"); /* The event must be written before it is published. */
+	key_ring_head = head + 1;
+}
+
+int keyboard_key_down( int key )
+{
+	if(key < 0 || key > 255) return 0;
+	return (key_state[key / 32] >> (key % 32)) & 1;
+}
+
+int keyboard_read_events( struct keyboard_event *e, int max )
+{
+	uint32_t tail = key_ring_tail;
+	uint32_t head = key_ring_head;
+	int total = 0;
+
+	asm volatile("" : : : "memory"); /* Read the events only after seeing the head. */
+	while(tail != head && total < max) {
+		e[total++] = key_ring[tail % KEYBOARD_RING_SIZE];
+		tail++;
+	}
+	key_ring_tail = tail;
+	return total;
+}
+
 static void keyboard_interrupt_l2( uint8_t code )
 {
 	int direction;
@@ -74,6 +135,8 @@ static void keyboard_interrupt_l2( uint8_t code )
 	} else if(k->special == KEYMAP_NUMLOCK) {
 		if(direction == 0) numlock_mode = !numlock_mode;
 	} else {
+		if((uint8_t) k->normal != KEY_INVALID) keyboard_state_update(k->normal, direction);
+
 		if(direction && ctrl_mode && alt_mode && k->normal == ASCII_DEL) {
 			reboot();
 		} else if(capslock_mode) {
@@ -7,6 +7,18 @@ See the file LICENSE for details.
 #ifndef KEYBOARD_H
 #define KEYBOARD_H
 
+#include "kernel/types.h"
+
+struct keyboard_event {
+	uint8_t key;	/* Unshifted character of the key */
+	uint8_t down;	/* 1 if pressed, 0 if released */
+};
+
 void keyboard_init();
 
+/* Polled keyboard state, independent of the event queue. */
+
+int keyboard_key_down( int key );
+int keyboard_read_events( struct keyboard_event *e, int max );
+
 #endif
@@ -6,6 +6,8 @@ See the file LICENSE for details.
 
 #include "console.h"
 #include "page.h"
+#include "pagetable.h"
+#include "vbe.h"
 #include "process.h"
 #include "keyboard.h"
 #include "mouse.h"
@@ -16,6 +18,7 @@ See the file LICENSE for details.
 #include "cdromfs.h"
 #include "string.h"
 #include "graphics.h"
+#include "bitmap.h"
 #include "kernel/ascii.h"
 #include "kernel/syscall.h"
 #include "rtc.h"
@@ -26,6 +29,8 @@ See the file LICENSE for details.
 #include "cdromfs.h"
 #include "diskfs.h"
 #include "serial.h"
+#include "game.h"
+#include "backend.h"
 /*
 This is the C initialization point of the kernel.
 By the time we reach this point, we are in protected mode,
@@ -51,388 +56,193 @@ const struct graphics_color color_array[] = { // The part of the Ansi escape seq
 	{0xFF, 0xFF, 0},
 	{0xFF, 0xFF, 0xFF}};
 
-#define BLACK 0
-#define BLUE 1
-#define GREEN 2
-#define CYAN 3
-#define RED 4
-#define MAGENTA 5
-#define BROWN 6
-#define LIGHT_GRAY 7
-#define DARK_GRAY 8
-#define LIGHT_BLUE 9
-#define LIGHT_GREEN 10
-#define LIGHT_CYAN 11
-#define LIGHT_RED 12
-#define LIGHT_MAGENTA 13
-#define YELLOW 14
-#define WHITE 15
-
-typedef enum
-{
-	false,
-	true
-} mbool; // define bool as enum to increase readability
+#ifndef STRESS_ASTEROIDS
+#define STRESS_ASTEROIDS 0 // Set to e.g. 2000 (or build with -DSTRESS_ASTEROIDS=2000) to fill the screen with asteroids and show frame times
+#endif
 
-#define TEXT_PIXEL_WIDTH 8
-#define TEXT_PIXEL_HEIGHT 7
+#ifndef GRAPHICS_BENCHMARK
+#define GRAPHICS_BENCHMARK 0 // Build with -DGRAPHICS_BENCHMARK=1 to print the fill rate of the graphics code before the game starts
+#endif
 
-struct Space_Ship
-{
-	int x;
-	int y;
-};
+/*
+The game itself lives in the shared core (Game/game.c), this file only
+connects it to the kernel: graphics_root for drawing, the keyboard
+driver's key state for keys and the clock for time.
+*/
 
-struct Bullet
-{
-	mbool active;
-	int x;
-	int y;
-};
+#define GAME_KEY_EVENTS 32
+
+struct keyboard_event key_events[GAME_KEY_EVENTS]; // Events taken from the keyboard but not yet given to the game
+int key_event_count;
+int key_event_next;
 
-#define NUMBER_OF_ASTEROIDS 3
-struct Asteroid
+/*
+The ship and every asteroid size and color are drawn once at startup
+into bitmaps, and each frame only copies them to the screen with
+graphics_blit. Pixels left in sprite_key are not copied, so the sprites
+are not boxes. If a sprite couldn't be made, the shape is drawn directly.
+*/
+
+const struct graphics_color sprite_key = {0xFF, 0, 0xFF}; // Not used by any sprite
+struct bitmap *ship_sprite;
+struct bitmap *asteroid_sprite[ASTEROID_PHASES][2]; // Normal and exploding
+
+void draw_ship(struct graphics *g, int x, int y) // The ship covers 72x31 pixels
 {
-	mbool active;
-	int x;
-	int y;
-	mbool explode;
-	int phase;
-};
-struct Space_Ship space_ship;
-struct Bullet bullet;
-struct Asteroid asteroids[NUMBER_OF_ASTEROIDS];
-
-char current_key = 0;
-mbool key_pressed = false;
-mbool game_start = false;
-mbool game_over = false;
-mbool game_restart = false;
-mbool game_pause = false;
-int life = 3;
-int score = 0;
-char Score[3];
-
-void init_space_ship() // Function that places space_ship in the bottom middle
+	graphics_rect(g, x + 20, y + 15, 30, 5, color_array[DARK_GRAY]);
+	graphics_tri(g, x, y + 30, x + 20, y + 25, x + 30, y + 2, color_array[WHITE]);
+	graphics_tri(g, x + 71, y + 30, x + 51, y + 25, x + 41, y + 2, color_array[WHITE]);
+	graphics_tri(g, x + 30, y + 15, x + 36, y, x + 41, y + 15, color_array[LIGHT_RED]);
+	graphics_circ(g, x + 35, y + 2, 2, color_array[YELLOW]);
+}
+
+void draw_asteroid(struct graphics *g, int x, int y, int w, int exploding)
 {
-	space_ship.x = (video_xres - 71) / 2; // pos = middle bottom
-	space_ship.y = video_yres - 30;
+	graphics_circ(g, x + w / 2, y + w / 2, w / 2, color_array[exploding ? RED : LIGHT_GRAY]);
 }
 
-void init_asteroids() // Function that clears and initializes the asteroids[]
+struct bitmap *sprite_create(int w, int h, struct graphics **g) // Function that returns an empty sprite and a graphics to draw into it
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
+	struct bitmap *b = bitmap_create(w, h, graphics_format(&graphics_root)); // Same format as the screen, so blits are plain copies
+	if (!b)
+		return 0;
+	*g = graphics_create_bitmap(b);
+	if (!*g)
 	{
-		asteroids[i].active = false; // Disable all asteroids so they can be (re)spawn
+		bitmap_delete(b);
+		return 0;
 	}
+	graphics_rect(*g, 0, 0, w, h, sprite_key);
+	return b;
 }
 
-void kprint_at(int x, int y, const char *str, int color)
+void sprite_cache_init(const struct game_config *c)
 {
-	graphics_fgcolor(&graphics_root, color_array[color]);
+	struct graphics *g;
+
+	ship_sprite = sprite_create(72, 31, &g);
+	if (ship_sprite)
+	{
+		draw_ship(g, 0, 0);
+		graphics_delete(g);
+	}
 
-	while (*str != '\0') // For each character
+	for (int phase = 0; phase < ASTEROID_PHASES; phase++)
 	{
-		graphics_char(&graphics_root, x, y, *str++);
-		x += TEXT_PIXEL_WIDTH;
+		int w = c->asteroid_width[phase] + 1; // The same box as the game gives to backend_draw_asteroid
+		for (int exploding = 0; exploding < 2; exploding++)
+		{
+			asteroid_sprite[phase][exploding] = sprite_create(w, w, &g);
+			if (asteroid_sprite[phase][exploding])
+			{
+				draw_asteroid(g, 0, 0, w, exploding);
+				graphics_delete(g);
+			}
+		}
 	}
-	// graphics_char(&graphics_root,video_xres / 2, video_yres / 2,'');
 }
 
-void clear_screen()
+void *backend_alloc(unsigned size)
 {
-	graphics_clear(&graphics_root, 0, 0, graphics_width(&graphics_root), graphics_height(&graphics_root));
+	return kmalloc(size);
 }
 
-void game_init() // Function that initializes and resets all game variables
+void backend_free(void *ptr)
 {
-	init_space_ship();
-	init_asteroids();
-	bullet.active = false;
-	clear_screen();
-	score = 0;
-	life = 3;
+	kfree(ptr);
 }
 
-void print_score() // Function that writes the score in the upper right corner of the screen
+void backend_clear(void)
 {
-
-	int temp = score;
-	for (int i = 2; i > -1; i--)
-	{
-		Score[i] = (char)temp % 10 + '0';
-		temp /= 10;
-	}
-	kprint_at(video_xres - 10 * TEXT_PIXEL_WIDTH, 8, "Score:", LIGHT_CYAN);
-	kprint_at(video_xres - 4 * TEXT_PIXEL_WIDTH, 8, Score, WHITE);
+	graphics_clear(&graphics_root, 0, 0, graphics_width(&graphics_root), graphics_height(&graphics_root));
 }
 
-void print_life() // Function that writes the life in the upper left corner of the screen
+void backend_erase(int x, int y, int w, int h)
 {
-	char life_char[2] = {(char)life + '0', '\0'};
-	kprint_at(8, 8, "Life:", LIGHT_GREEN);
-	kprint_at(8 + 5 * TEXT_PIXEL_WIDTH, 8, life_char, WHITE);
+	graphics_clear(&graphics_root, x, y, w, h);
 }
 
-void move_and_fire_space_ship() // Function that takes keyboard inputs and determines the movements of the spaceship and the starting point of the bullet according to these inputs
+void backend_print(int x, int y, const char *str, int color) // kprint_at
 {
-	if (key_pressed)
-	{
-		switch (current_key) // If the same or a different key is pressed again
-		{
-		// case 'w':
-		// 	space_ship.y--;
-		// 	break;
-		// case 's':
-		// 	space_ship.y++;
-		// 	break;
-		case 'a':
-			if (space_ship.x > 5)
-				space_ship.x -= 5;
-			break;
-		case 'd':
-			if (space_ship.x < video_xres - 75)
-				space_ship.x += 5;
-			break;
-		case ' ':
-			if (!bullet.active) // If a bullet has been fired, a new bullet cannot be fired until that bullet hits something.
-			{
-				bullet.y = space_ship.y + 10;
-				bullet.x = space_ship.x + 34;
-				bullet.active = true;
-			}
-			break;
-		case 'r':
-			game_restart = true;
-			break;
-		case 'p':
-			game_pause = true;
-			break;
-		}
-		key_pressed = false; // After the key is processed, the flag will be set to false so that it does not enter the same place again.
-	}
+	graphics_fgcolor(&graphics_root, color_array[color]);
+	graphics_string(&graphics_root, x, y, str, strlen(str)); // The whole string in one call
 }
 
-void draw_space_ship(mbool draw) // Function that draws and deletes the space_ship
+void backend_draw_ship(int x, int y, int w, int h)
 {
-	if (draw) // Draw space_ship if true
-	{
-		graphics_rect(&graphics_root, space_ship.x + 20, space_ship.y + 15, 30, 5, color_array[DARK_GRAY]);
-		graphics_tri(&graphics_root, space_ship.x, space_ship.y + 30, space_ship.x + 20, space_ship.y + 25, space_ship.x + 30, space_ship.y + 2, color_array[WHITE]);
-		graphics_tri(&graphics_root, space_ship.x + 71, space_ship.y + 30, space_ship.x + 51, space_ship.y + 25, space_ship.x + 41, space_ship.y + 2, color_array[WHITE]);
-		graphics_tri(&graphics_root, space_ship.x + 30, space_ship.y + 15, space_ship.x + 36, space_ship.y, space_ship.x + 41, space_ship.y + 15, color_array[LIGHT_RED]);
-		graphics_circ(&graphics_root, space_ship.x + 35, space_ship.y + 2, 2, color_array[YELLOW]);
-	}
-	else // If false delete
-	{
-		graphics_clear(&graphics_root, space_ship.x, space_ship.y, 71, 30);
-		// graphics_rect(&graphics_root, space_ship.x, space_ship.y, 71, 30, color_array[WHITE]);
-	}
+	if (ship_sprite)
+		graphics_blit(&graphics_root, x, y, ship_sprite, &sprite_key);
+	else
+		draw_ship(&graphics_root, x, y);
 }
 
-void move_bullets() // Function that moves the bullet
+void backend_draw_bullet(int x, int y, int w, int h)
 {
-	if (bullet.y > 10 && bullet.active) // If the bullet doesn't reach the top, move the bullet up
-	{
-		bullet.y -= 20;
-	}
-	else if (bullet.active) // If the bullet has reached the top and is active, deactivate the bullet so it can be fired again
-	{
-		bullet.active = false;
-	}
+	graphics_rect(&graphics_root, x, y, w, h, color_array[YELLOW]);
 }
 
-void draw_bullets(mbool draw) //
+void backend_draw_asteroid(int x, int y, int w, int h, int phase, int exploding) // Size depends on the phase and color on the explosion
 {
-	if (draw && bullet.active) // Draw  bullet if the bullet is active and true
-	{
-		// kprint_at(bullet.x, bullet.y, "|", YELLOW);
-		graphics_rect(&graphics_root, bullet.x, bullet.y, 3, 10, color_array[YELLOW]);
-	}
-	else // If false delete
-	{
-		graphics_clear(&graphics_root, bullet.x, bullet.y, 3, 10);
-	}
+	struct bitmap *sprite = asteroid_sprite[phase][exploding];
+	if (sprite && sprite->width == w && sprite->height == h)
+		graphics_blit(&graphics_root, x, y, sprite, &sprite_key);
+	else
+		draw_asteroid(&graphics_root, x, y, w, exploding);
 }
 
-void spawn_asteroids() // Function that spawns passive asteroids from a random x location
+void backend_draw_fragment(int x, int y, int w, int h, int color)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		if (!asteroids[i].active)
-		{
-			asteroids[i].x = rand(100, video_xres - 130); // 100 - (video_xres - 130) range
-			asteroids[i].y = 70;
-			asteroids[i].explode = false;
-			asteroids[i].phase = 0;
-			asteroids[i].active = true;
-			return;
-		}
-	}
+	graphics_rect(&graphics_root, x, y, w, h, color_array[color]);
 }
 
-void move_asteroids()
+void backend_present(void)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		if (asteroids[i].active) // Active ones move
-		{
-			asteroids[i].y+=10;
-			if (asteroids[i].explode)
-			{
-				asteroids[i].explode = false; // Reset explosion status when you move
-				if (asteroids[i].phase < 3)	  // If the size of asteroid is not the smalles, reduce the size
-				{
-					asteroids[i].phase++; // increasing phase means decreasing size
-				}
-				else // If it becomes the smallest, deactivate it
-					asteroids[i].active = false;
-			}
-			if ((asteroids[i].x > space_ship.x && asteroids[i].x < space_ship.x + 71 && asteroids[i].y > space_ship.y - 55) || (asteroids[i].y > video_yres - 55)) // If it reaches the bottom of the screen (below the spaceship), lose life and deactivate.
-			{
-				asteroids[i].active = false;
-				life--;
-			}
-		}
-	}
+	graphics_present(&graphics_root); // Copy this frame's damaged regions to the screen in one pass
 }
 
-void draw_asteroid(int id, mbool draw) // Function to draw a single Asteroid and determine its hitboxes
+int backend_read_key(void) // Takes the key events from the keyboard ring, all of them in one call per frame
 {
-	if (asteroids[id].active)
+	while (1)
 	{
-		switch (asteroids[id].phase) // Enter one of the cases depending on the phase of the active asteroids
+		if (key_event_next == key_event_count)
 		{
-		case 0:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 55, color_array[LIGHT_GRAY]);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 55, color_array[RED]);
-			}
-			else
-			{
-				graphics_clear(&graphics_root, asteroids[id].x - 55, asteroids[id].y - 55, 112, 112);
-			}
-			break;
-
-		case 1:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 40, color_array[LIGHT_GRAY]);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 40, color_array[RED]);
-			}
-			else
-			{
-				graphics_clear(&graphics_root, asteroids[id].x - 40, asteroids[id].y - 40, 82, 82);
-			}
-			break;
-
-		case 2:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 25, color_array[LIGHT_GRAY]);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 25, color_array[RED]);
-			}
-			else
-			{
-				graphics_clear(&graphics_root, asteroids[id].x - 25, asteroids[id].y - 25, 52, 52);
-			}
-			break;
-
-		case 3:
-			// Determine size according to phase
-			if (draw && !asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 15, color_array[LIGHT_GRAY]);
-			}
-			else if (draw && asteroids[id].explode)
-			{
-				graphics_circ(&graphics_root, asteroids[id].x, asteroids[id].y, 15, color_array[RED]);
-			}
-			else
-			{
-				graphics_clear(&graphics_root, asteroids[id].x - 15, asteroids[id].y - 15, 32, 32);
-			}
-			break;
+			key_event_count = keyboard_read_events(key_events, GAME_KEY_EVENTS);
+			key_event_next = 0;
+			if (!key_event_count)
+				return 0;
 		}
+		struct keyboard_event *e = &key_events[key_event_next++];
+		if (e->down)
+			return e->key;
 	}
 }
 
-void draw_asteroids(mbool draw) // Function to draw all asteroids
+int backend_key_held(int key)
 {
-	for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++)
-	{
-		draw_asteroid(i, draw); // We draw them all one by one using the method
-	}
+	return keyboard_key_down(key);
 }
 
-mbool check_collision(int x, int y) // Function that controls simple color-check collision
+unsigned backend_millis(void)
 {
-	for (int i = x; i < x + 3; i++)
-	{
-		struct graphics_color c = get_pixel_color(&graphics_root, i, y);
-		if ( (c.r != 0 && 0xAA) || c.g != 0 || c.b != 0)
-			return true;
-	}
-	return false;
+	clock_t now = clock_read();
+	return now.seconds * 1000 + now.millis;
 }
-void collision_event() // Function that handles collisions and life checking
-{
-	if (check_collision(bullet.x, bullet.y) && bullet.y > 16) //If collision find out which asteroid it hit
-	{
 
-		float closest_dist = 1000.0f;
-		int closest_id = 0;
-		for (int i = 0; i < NUMBER_OF_ASTEROIDS; i++) // To calculate all distances and get the closest one
-		{
-			//Formula for distance between two points sqrt2(pow(x1-x2)+pow(y1-y2))
-			int asteroid_dist = sqrt2((asteroids[i].x - bullet.x)*(asteroids[i].x - bullet.x) + (asteroids[i].y - bullet.y)*(asteroids[i].y - bullet.y));
-			if(closest_dist > asteroid_dist)
-			{
-				closest_dist = asteroid_dist;
-				closest_id = i;
-			}
-		}
-		//After find we reset bullet and 
-		bullet.x = 0;
-		bullet.y = 0;
-		bullet.active = false;
-		asteroids[closest_id].explode = true; // Set the explode flag (of the asteroid we found) to true  
-		score++;
-	}
-	if (life <= 0)
-		game_over = true;
+void backend_wait(int millis) // Keys don't wake the clock queue, so sleep one tick at a time and let the game poll
+{
+	if (millis != 0)
+		clock_wait(1);
 }
 
-static unsigned long next; // Random Seeder
-
-int rand(int start, int end) // Function that generate a pseudo-random integer
+unsigned backend_timer(void)
 {
-	next = next * 1103515245 + 12345;
-	return (unsigned int)(next / 65536) % (end - start) + start;
+	return clock_tsc();
 }
 
-/*
-All changes we made to files other than main.c are as follows. 
-(A means Added, C means Changed)
-event_queue.c, A: 41-49
-graphics.c, A: 225-366, C: 368
-graphics.h, A: 34-37, C: 38
-console.c, A: 155, C: 148
-console.h, C: 39
-*/
+unsigned backend_timer_usec(unsigned ticks)
+{
+	return clock_tsc_usec(ticks);
+}
 
 int kernel_main()
 {
@@ -444,94 +254,42 @@ int kernel_main()
 	keyboard_init();
 	rtc_init();
 	clock_init();
+	uint32_t fill_before = graphics_fill_rate(&graphics_root); // Paging is still off, so this is the default memory type
+	int writecombine = pagetable_pat_init(); // Must come before the first pagetable maps the framebuffer
+	vbe_flip_init(); // Likewise, so that the second page is mapped too
 	process_init();
+	if (writecombine)
+		printf("graphics: fill rate %u MB/s by default, %u MB/s write-combining\n", fill_before, graphics_fill_rate(&graphics_root));
+	else
+		printf("graphics: fill rate %u MB/s\n", fill_before);
 	current->ktable[KNO_STDIN] = kobject_create_console(console);
 	current->ktable[KNO_STDOUT] = kobject_copy(current->ktable[0]);
 	current->ktable[KNO_STDERR] = kobject_copy(current->ktable[1]);
 	current->ktable[KNO_STDWIN] = kobject_create_window(&window_root);
 	current->ktable[KNO_STDDIR] = 0; // No current dir until something is mounted.
 
-	next = 	boottime; // seeding next value using rtc_boottime_value
-
-Restart_Game:
-	game_init();
-
-	if (!game_start)
-		kprint_at((video_xres - 11 * TEXT_PIXEL_WIDTH) / 2, video_yres / 2, "Start Game", LIGHT_GRAY); // Appears only on first startup
-	game_start = true;
-
-	if (game_restart)
-	{ // Appears on every restart
-		kprint_at((video_xres - 10 * TEXT_PIXEL_WIDTH) / 2, (video_yres / 2) - 10, "Score:", LIGHT_CYAN);
-		kprint_at(((video_xres - 10 * TEXT_PIXEL_WIDTH) / 2) + 6 * TEXT_PIXEL_WIDTH, (video_yres / 2) - 10, Score, WHITE);
-		kprint_at((video_xres - 13 * TEXT_PIXEL_WIDTH) / 2, video_yres / 2, "Restart Game", LIGHT_GRAY);
-	}
-	game_restart = false;
-
-	if (game_over)
-	{ // Appears on every gameover
-		kprint_at((video_xres - 10 * TEXT_PIXEL_WIDTH) / 2, (video_yres / 2) - 10, "Score:", LIGHT_CYAN);
-		kprint_at(((video_xres - 10 * TEXT_PIXEL_WIDTH) / 2) + 6 * TEXT_PIXEL_WIDTH, (video_yres / 2) - 10, Score, WHITE);
-		kprint_at((video_xres - 10 * TEXT_PIXEL_WIDTH) / 2, video_yres / 2, "Game Over", LIGHT_GRAY);
+	struct game_config config;
+	game_config_graphics(&config, video_xres, video_yres);
+	config.stress_asteroids = STRESS_ASTEROIDS;
+	struct game *game = game_create(&config, boottime); // seeding the random numbers using rtc_boottime_value
+	if (!game)
+	{
+		printf("game: out of memory\n");
+		return 0;
 	}
-	game_over = false;
-
-	for (int i = 0; i < 3; i++)
-		Score[i] = '0'; // Clear Score Array
-	int loop_step = 0;	// We create(reset) the loop counter to create delay.
-
-	kprint_at((video_xres - 33 * TEXT_PIXEL_WIDTH) / 2, 10, "180101012 - Ibrahim Yusuf Cosgun", DARK_GRAY);
 
-Pause_Game:
-	if (game_pause)
-		kprint_at((video_xres - 14 * TEXT_PIXEL_WIDTH) / 2, video_yres / 2, "Continue Game", LIGHT_GRAY);
-	game_pause = false;
+	sprite_cache_init(&config);
 
-	kprint_at((video_xres - 14 * TEXT_PIXEL_WIDTH) / 2, (video_yres / 2) + 10, "Press [Enter]", DARK_GRAY); // Appears always
-
-	while (current_key != ASCII_CR)
+	if (GRAPHICS_BENCHMARK)
 	{
-		console_read(console, &current_key, 1);
+		graphics_benchmark(&graphics_root);
+		clock_wait(5000); // Time to read the results
 	}
 
-	clear_screen();
-	while (1)
-	{
-		console_read_nonblock(console, &current_key, 1, &key_pressed);
-		if (game_restart || game_over) // Proper reset with goto in case of gameover or restart of the game
-			goto Restart_Game;
-
-		if (game_pause) // Pause by just freezing the screen without resetting game objects (Buffer is not a game object, it makes the printing process faster and in one piece.)
-			goto Pause_Game;
+	if (!graphics_backbuffer_enable(&graphics_root)) // Draw off-screen and present only the damaged regions each frame
+		printf("game: no memory for back buffer, drawing directly\n");
 
-		clock_wait(50); // Sleep 50ms
-
-		// Clear
-		draw_space_ship(false);
-		draw_bullets(false);
-
-		// Move and do Events
-		move_and_fire_space_ship();
-		move_bullets();
-		if (loop_step++ % 120 == 0)
-		{
-			spawn_asteroids();
-		}
-		if (loop_step % 10 == 0)
-		{
-			// Before Movement Clear Asteroids
-			draw_asteroids(false);
-			move_asteroids();
-		}
-		collision_event();
-
-		// Print
-		draw_space_ship(true);
-		draw_bullets(true);
-		draw_asteroids(true);
-		print_score();
-		print_life();
-	}
+	game_run(game);
 
 	return 0;
 }
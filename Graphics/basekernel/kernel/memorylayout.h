@@ -78,3 +78,12 @@ grow down.  Addresses below 0x80000000 are all supervisor mode.
 
 #define PROCESS_ENTRY_POINT 0x80000000
 #define PROCESS_STACK_INIT  0xfffffff0
+
+/*
+A window pixel surface is mapped into the process at a fixed slot
+for the object descriptor it was requested through, starting at
+PROCESS_SURFACE_BASE, well between the heap and the stack.
+*/
+
+#define PROCESS_SURFACE_BASE 0xc0000000
+#define PROCESS_SURFACE_SLOT 0x00400000
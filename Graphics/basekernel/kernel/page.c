@@ -95,6 +95,52 @@ void *page_alloc(bool zeroit)
 	return 0;
 }
 
+/*
+Allocate a run of npages physically contiguous pages, for the
+few kernel objects (such as the graphics back buffer) that are
+too large for kmalloc and must be addressed linearly.
+*/
+
+void *page_alloc_contiguous(uint32_t npages, bool zeroit)
+{
+	uint32_t i, start, length;
+	void *pageaddr;
+
+	if(!freemap) {
+		printf("memory: not initialized yet!\n");
+		return 0;
+	}
+
+	start = length = 0;
+	for(i = 0; i < freemap_bits; i++) {
+		if(freemap[i / CELL_BITS] & (1 << (i % CELL_BITS))) {
+			if(length == 0)
+				start = i;
+			length++;
+			if(length == npages)
+				break;
+		} else {
+			length = 0;
+		}
+	}
+
+	if(length < npages) {
+		printf("memory: couldn't find %d contiguous pages\n", npages);
+		return 0;
+	}
+
+	for(i = start; i < start + npages; i++) {
+		freemap[i / CELL_BITS] &= ~(1 << (i % CELL_BITS));
+	}
+	pages_free -= npages;
+
+	pageaddr = (start << PAGE_BITS) + main_memory_start;
+	if(zeroit)
+		memset(pageaddr, 0, npages * PAGE_SIZE);
+
+	return pageaddr;
+}
+
 void page_free(void *pageaddr)
 {
 	uint32_t pagenumber = (pageaddr - main_memory_start) >> PAGE_BITS;
@@ -11,6 +11,7 @@ See the file LICENSE for details.
 
 void  page_init();
 void *page_alloc(bool zeroit);
+void *page_alloc_contiguous(uint32_t npages, bool zeroit);
 void  page_free(void *addr);
 void  page_stats( uint32_t *nfree, uint32_t *ntotal );
 
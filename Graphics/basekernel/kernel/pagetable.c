@@ -8,6 +8,7 @@ See the file LICENSE for details.
 #include "page.h"
 #include "string.h"
 #include "kernelcore.h"
+#include "vbe.h"
 
 #define ENTRIES_PER_TABLE (PAGE_SIZE/4)
 
@@ -32,6 +33,62 @@ struct pagetable {
 	struct pageentry entry[ENTRIES_PER_TABLE];
 };
 
+/*
+If the processor has a page attribute table, entry 1 is changed from
+write-through to write-combining, and pages mapped with
+PAGE_FLAG_WRITECOMBINE select it with the writethrough bit.  Writes
+to such pages are gathered into bursts instead of going to the bus
+one at a time, which suits the framebuffer.  Without a PAT, the flag
+is ignored and the pages get the default caching.
+*/
+
+#define MSR_PAT 0x277
+#define PAT_ENTRY1_MASK 0x0000ff00
+#define PAT_ENTRY1_WRITECOMBINE 0x00000100
+
+static int pat_enabled = 0;
+
+static int cpu_has_pat()
+{
+	uint32_t a, b, c, d, flags, toggled;
+
+	/* CPUID exists if the ID bit of EFLAGS can be changed. */
+	asm volatile("pushfl\n"
+		     "popl %0\n"
+		     "movl %0, %1\n"
+		     "xorl $0x200000, %1\n"
+		     "pushl %1\n"
+		     "popfl\n"
+		     "pushfl\n"
+		     "popl %1\n"
+		     "pushl %0\n"
+		     "popfl" : "=&r"(flags), "=&r"(toggled));
+	if(!((flags ^ toggled) & 0x200000)) return 0;
+
+	asm volatile("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1));
+	return (d >> 16) & 1;
+}
+
+int pagetable_pat_init()
+{
+	uint32_t lo, hi;
+
+	if(!cpu_has_pat()) {
+		printf("memory: no PAT, framebuffer has default caching\n");
+		return 0;
+	}
+
+	asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(MSR_PAT));
+	lo = (lo & ~PAT_ENTRY1_MASK) | PAT_ENTRY1_WRITECOMBINE;
+	asm volatile("wbinvd" : : : "memory");
+	asm volatile("wrmsr" : : "a"(lo), "d"(hi), "c"(MSR_PAT));
+	asm volatile("wbinvd" : : : "memory");
+
+	pat_enabled = 1;
+	printf("memory: framebuffer is write-combining\n");
+	return 1;
+}
+
 struct pagetable *pagetable_create()
 {
 	return page_alloc(1);
@@ -44,9 +101,9 @@ void pagetable_init(struct pagetable *p)
 	for(i = 0; i < stop; i += PAGE_SIZE) {
 		pagetable_map(p, i, i, PAGE_FLAG_KERNEL | PAGE_FLAG_READWRITE);
 	}
-	stop = (unsigned) video_buffer + video_xres * video_yres * 3;
+	stop = (unsigned) video_buffer + video_xbytes * video_yres * video_pages;
 	for(i = (unsigned) video_buffer; i <= stop; i += PAGE_SIZE) {
-		pagetable_map(p, i, i, PAGE_FLAG_KERNEL | PAGE_FLAG_READWRITE);
+		pagetable_map(p, i, i, PAGE_FLAG_KERNEL | PAGE_FLAG_READWRITE | PAGE_FLAG_WRITECOMBINE);
 	}
 }
 
@@ -78,6 +135,8 @@ int pagetable_getmap(struct pagetable *p, unsigned vaddr, unsigned *paddr, int *
 			*flags |= PAGE_FLAG_ALLOC;
 		if(!e->user)
 			*flags |= PAGE_FLAG_KERNEL;
+		if(e->writethrough)
+			*flags |= PAGE_FLAG_WRITECOMBINE;
 	}
 
 	return 1;
@@ -124,7 +183,7 @@ int pagetable_map(struct pagetable *p, unsigned vaddr, unsigned paddr, int flags
 	e->present = 1;
 	e->readwrite = (flags & PAGE_FLAG_READWRITE) ? 1 : 0;
 	e->user = (flags & PAGE_FLAG_KERNEL) ? 0 : 1;
-	e->writethrough = 0;
+	e->writethrough = (flags & PAGE_FLAG_WRITECOMBINE) && pat_enabled;
 	e->nocache = 0;
 	e->accessed = 0;
 	e->dirty = 0;
@@ -17,9 +17,11 @@ See the file LICENSE for details.
 #define PAGE_FLAG_READWRITE   4
 #define PAGE_FLAG_NOCLEAR     0
 #define PAGE_FLAG_CLEAR       8
+#define PAGE_FLAG_WRITECOMBINE 16
 
 struct pagetable *pagetable_create();
 void pagetable_init(struct pagetable *p);
+int pagetable_pat_init();
 int pagetable_map(struct pagetable *p, unsigned vaddr, unsigned paddr, int flags);
 int pagetable_getmap(struct pagetable *p, unsigned vaddr, unsigned *paddr, int *flags);
 void pagetable_unmap(struct pagetable *p, unsigned vaddr);
@@ -26,6 +26,7 @@ See the file LICENSE for details.
 #include "page.h"
 #include "ata.h"
 #include "window.h"
+#include "bitmap.h"
 #include "is_valid.h"
 #include "bcache.h"
 
@@ -384,6 +385,66 @@ int sys_open_window(int wd, int x, int y, int w, int h)
 	return fd;
 }
 
+/*
+Map the pixel surface of window wd into the slot of the current
+process reserved for wd, and describe it in *s.  The pages belong
+to the window, so they are mapped without PAGE_FLAG_ALLOC and are
+not freed with the process.
+*/
+
+int sys_window_surface(int wd, struct graphics_surface *s)
+{
+	if(!is_valid_object_type(wd,KOBJECT_WINDOW)) return KERROR_INVALID_OBJECT;
+	if(!is_valid_pointer(s,sizeof(*s))) return KERROR_INVALID_ADDRESS;
+
+	struct bitmap *b = window_surface(current->ktable[wd]->data.window);
+	if(!b) return KERROR_OUT_OF_MEMORY;
+
+	uint32_t size = b->pitch * b->height;
+	if(size > PROCESS_SURFACE_SLOT) return KERROR_OUT_OF_SPACE;
+
+	unsigned vaddr = PROCESS_SURFACE_BASE + wd * PROCESS_SURFACE_SLOT;
+	unsigned i;
+	for(i = 0; i < size; i += PAGE_SIZE) {
+		if(!pagetable_map(current->pagetable, vaddr + i, (unsigned) b->data + i, PAGE_FLAG_USER | PAGE_FLAG_READWRITE)) {
+			pagetable_free(current->pagetable, vaddr, PROCESS_SURFACE_SLOT);
+			pagetable_refresh();
+			return KERROR_OUT_OF_MEMORY;
+		}
+	}
+	pagetable_refresh();
+
+	s->pixels = (uint8_t *) vaddr;
+	s->width = b->width;
+	s->height = b->height;
+	s->pitch = b->pitch;
+	s->bpp = BITMAP_BYTES_PER_PIXEL(b->format);
+	return 0;
+}
+
+/* Copy the damaged rectangles of the surface of window wd to the screen. */
+
+int sys_window_present(int wd, const struct graphics_rect *rects, int count)
+{
+	if(!is_valid_object_type(wd,KOBJECT_WINDOW)) return KERROR_INVALID_OBJECT;
+	if(count < 0) return KERROR_INVALID_REQUEST;
+	if(!is_valid_pointer((void *) rects,count*sizeof(*rects))) return KERROR_INVALID_ADDRESS;
+
+	return window_present(current->ktable[wd]->data.window,rects,count);
+}
+
+int sys_window_move(int wd, int x, int y)
+{
+	if(!is_valid_object_type(wd,KOBJECT_WINDOW)) return KERROR_INVALID_OBJECT;
+	return window_move(current->ktable[wd]->data.window,x,y);
+}
+
+int sys_window_raise(int wd)
+{
+	if(!is_valid_object_type(wd,KOBJECT_WINDOW)) return KERROR_INVALID_OBJECT;
+	return window_raise(current->ktable[wd]->data.window);
+}
+
 int sys_open_pipe()
 {
 	int fd = process_available_fd(current);
@@ -463,6 +524,13 @@ int sys_object_close(int fd)
 	if(!is_valid_object(fd)) return KERROR_INVALID_OBJECT;
 
 	struct kobject *p = current->ktable[fd];
+
+	/* Drop any surface mapped through this descriptor; the window owns the pages. */
+	if(kobject_get_type(p)==KOBJECT_WINDOW) {
+		pagetable_free(current->pagetable, PROCESS_SURFACE_BASE + fd * PROCESS_SURFACE_SLOT, PROCESS_SURFACE_SLOT);
+		pagetable_refresh();
+	}
+
 	kobject_close(p);
 	current->ktable[fd] = 0;
 	return 0;
@@ -633,6 +701,14 @@ int32_t syscall_handler(syscall_t n, uint32_t a, uint32_t b, uint32_t c, uint32_
 		return sys_system_rtc((struct rtc_time *) a);
 	case SYSCALL_DEVICE_DRIVER_STATS:
 		return sys_device_driver_stats((char *) a, (struct device_driver_stats *) b);
+	case SYSCALL_WINDOW_SURFACE:
+		return sys_window_surface(a, (struct graphics_surface *) b);
+	case SYSCALL_WINDOW_PRESENT:
+		return sys_window_present(a, (const struct graphics_rect *) b, c);
+	case SYSCALL_WINDOW_MOVE:
+		return sys_window_move(a, b, c);
+	case SYSCALL_WINDOW_RAISE:
+		return sys_window_raise(a);
 	default:
 		return KERROR_INVALID_SYSCALL;
 	}
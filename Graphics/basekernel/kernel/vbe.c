@@ -0,0 +1,112 @@
+/*
+Copyright (C) 2016-2019 The University of Notre Dame
+This software is distributed under the GNU General Public License.
+See the file LICENSE for details.
+*/
+
+/*
+Page flipping for the linear framebuffer.  The mode is set in real
+mode by kernelcore.S, which also asks the BIOS for the longest
+virtual screen that fits in video memory.  Once in protected mode
+the BIOS (and so VBE function 0x4f07) can no longer be called, but
+the Bochs and QEMU adapters expose the same display start through
+the "dispi" I/O registers, which is what vbe_flip uses.
+*/
+
+#include "vbe.h"
+#include "clock.h"
+#include "ioports.h"
+#include "kernelcore.h"
+#include "string.h"
+
+#define DISPI_INDEX 0x01ce
+#define DISPI_DATA  0x01cf
+
+#define DISPI_INDEX_ID          0
+#define DISPI_INDEX_XRES        1
+#define DISPI_INDEX_YRES        2
+#define DISPI_INDEX_VIRT_HEIGHT 7
+#define DISPI_INDEX_Y_OFFSET    9
+
+#define DISPI_ID_MIN 0xb0c0
+#define DISPI_ID_MAX 0xb0cf
+
+#define VGA_INPUT_STATUS 0x03da
+#define VGA_RETRACE      0x08
+#define VGA_RETRACE_USEC 20000
+
+int video_pages = 1;
+
+static int vbe_vsync = 1;
+
+static uint16_t dispi_read(int index)
+{
+	outw(index, DISPI_INDEX);
+	return inw(DISPI_DATA);
+}
+
+static void dispi_write(int index, uint16_t value)
+{
+	outw(index, DISPI_INDEX);
+	outw(value, DISPI_DATA);
+}
+
+int vbe_flip_init()
+{
+	uint16_t id = dispi_read(DISPI_INDEX_ID);
+
+	if(id < DISPI_ID_MIN || id > DISPI_ID_MAX) {
+		printf("video: no page flipping, presenting by copy\n");
+		return video_pages;
+	}
+
+	/* The adapter must be showing the mode that the BIOS reported. */
+	if(dispi_read(DISPI_INDEX_XRES) != video_xres || dispi_read(DISPI_INDEX_YRES) != video_yres) {
+		printf("video: unexpected mode, presenting by copy\n");
+		return video_pages;
+	}
+
+	if(video_image_pages < 1 || dispi_read(DISPI_INDEX_VIRT_HEIGHT) < 2 * video_yres) {
+		printf("video: no room for a second page, presenting by copy\n");
+		return video_pages;
+	}
+
+	dispi_write(DISPI_INDEX_Y_OFFSET, 0);
+	video_pages = 2;
+	printf("video: page flipping with two %dx%d pages\n", video_xres, video_yres);
+	return video_pages;
+}
+
+/* Wait until the retrace bit reads as state, or about a frame has passed since start. */
+
+static int vbe_wait_retrace(int state, uint32_t start)
+{
+	while(!(inb(VGA_INPUT_STATUS) & VGA_RETRACE) != !state) {
+		if(clock_tsc_usec(clock_tsc() - start) > VGA_RETRACE_USEC) return 0;
+	}
+	return 1;
+}
+
+/*
+Show the given page, changing the display start during the vertical
+retrace so that no frame is made of two pages.  An adapter that does
+not report the retrace would cost a whole frame period on every flip,
+so after the first timeout pages are flipped without waiting.
+*/
+
+void vbe_flip(int page)
+{
+	uint32_t start;
+
+	if(page >= video_pages) return;
+
+	if(vbe_vsync) {
+		start = clock_tsc();
+		if(!vbe_wait_retrace(0, start) || !vbe_wait_retrace(1, start)) {
+			printf("video: no vertical retrace, flipping without it\n");
+			vbe_vsync = 0;
+		}
+	}
+
+	dispi_write(DISPI_INDEX_Y_OFFSET, page * video_yres);
+}
@@ -0,0 +1,21 @@
+/*
+Copyright (C) 2016-2019 The University of Notre Dame
+This software is distributed under the GNU General Public License.
+See the file LICENSE for details.
+*/
+
+#ifndef VBE_H
+#define VBE_H
+
+/*
+Number of screens of video memory that can be shown, starting at
+video_buffer: 2 if vbe_flip_init found a way to change the display
+start after boot, and 1 otherwise.
+*/
+
+extern int video_pages;
+
+int  vbe_flip_init();
+void vbe_flip(int page);
+
+#endif
@@ -1,17 +1,41 @@
 
 #include "window.h"
 #include "graphics.h"
+#include "bitmap.h"
+#include "kernel/error.h"
 #include "kmalloc.h"
 #include "string.h"
+#include "list.h"
+
+/*
+Each window created directly on the root window is composited: it
+draws into a backing store of its own, and the visible parts of the
+store are copied to the screen whenever the window is drawn into,
+moved, raised or uncovered.  The composited windows are kept in
+window_stack from the bottom up, and anything drawn into the root
+window itself forms the desktop underneath them.
+
+Windows inside a composited window remain clip rectangles within
+the store of their parent.  If a store cannot be allocated, the
+window falls back to drawing onto the desktop.
+*/
 
 struct window {
+	struct list_node node;		/* position in window_stack, if composited */
 	struct window *parent;
 	struct graphics *graphics;
 	struct event_queue *queue;
+	struct bitmap *surface;
+	struct bitmap *store;		/* backing store, if composited */
+	int x, y;			/* position within the parent */
+	int visible;			/* not completely covered by windows above */
 	int refcount;
 };
 
-struct window window_root = {0};
+struct window window_root = {{0}};
+
+static struct list window_stack = LIST_INIT;
+static struct graphics *window_screen = 0;
 
 struct window * window_create_root()
 {
@@ -20,21 +44,206 @@ struct window * window_create_root()
 	w->graphics = graphics_create_root();
 	w->queue = event_queue_create_root();
 	w->refcount = 1;
+	w->visible = 1;
 	return w;
 }
 
+static struct graphics_rect window_rect( struct window *w )
+{
+	struct graphics_rect r;
+	r.x = w->x;
+	r.y = w->y;
+	r.w = window_width(w);
+	r.h = window_height(w);
+	return r;
+}
+
+/* Reduce a to its overlap with b, returning zero if they do not overlap. */
+
+static int window_intersect( struct graphics_rect *a, const struct graphics_rect *b )
+{
+	int x1 = MAX(a->x, b->x);
+	int y1 = MAX(a->y, b->y);
+	int x2 = MIN(a->x + a->w, b->x + b->w);
+	int y2 = MIN(a->y + a->h, b->y + b->h);
+
+	if(x2 <= x1 || y2 <= y1) return 0;
+
+	a->x = x1;
+	a->y = y1;
+	a->w = x2 - x1;
+	a->h = y2 - y1;
+	return 1;
+}
+
+/*
+Split the part of a outside b into at most four bands, above, below,
+left and right of b, and return how many there are.
+*/
+
+static int window_subtract( struct graphics_rect a, struct graphics_rect b, struct graphics_rect *out )
+{
+	int n = 0;
+
+	if(!window_intersect(&b, &a)) {
+		out[0] = a;
+		return 1;
+	}
+
+	if(b.y > a.y) {
+		out[n].x = a.x;
+		out[n].y = a.y;
+		out[n].w = a.w;
+		out[n++].h = b.y - a.y;
+	}
+	if(b.y + b.h < a.y + a.h) {
+		out[n].x = a.x;
+		out[n].y = b.y + b.h;
+		out[n].w = a.w;
+		out[n++].h = a.y + a.h - b.y - b.h;
+	}
+	if(b.x > a.x) {
+		out[n].x = a.x;
+		out[n].y = b.y;
+		out[n].w = b.x - a.x;
+		out[n++].h = b.h;
+	}
+	if(b.x + b.w < a.x + a.w) {
+		out[n].x = b.x + b.w;
+		out[n].y = b.y;
+		out[n].w = a.x + a.w - b.x - b.w;
+		out[n++].h = b.h;
+	}
+
+	return n;
+}
+
+/*
+Show the parts of screen area r that no window from n upwards covers,
+copying them from the store of w, or clearing them to the desktop
+color if w is null.  If draw is zero, nothing is drawn.  Returns the
+number of pixels that are visible.
+*/
+
+static int window_expose_above( struct list_node *n, struct window *w, struct graphics_rect r, int draw )
+{
+	struct graphics_rect parts[4];
+	int i, count, visible = 0;
+
+	for(; n; n = n->next) {
+		struct graphics_rect o = window_rect((struct window *) n);
+		if(!window_intersect(&o, &r)) continue;
+
+		count = window_subtract(r, o, parts);
+		for(i = 0; i < count; i++) {
+			visible += window_expose_above(n->next, w, parts[i], draw);
+		}
+		return visible;
+	}
+
+	if(draw) {
+		if(w) {
+			graphics_blit_rect(window_screen, r.x, r.y, w->store, r.x - w->x, r.y - w->y, r.w, r.h, 0);
+		} else {
+			graphics_clear(window_screen, r.x, r.y, r.w, r.h);
+		}
+	}
+
+	return r.w * r.h;
+}
+
+/* Copy the visible parts of screen area r of composited window w to the screen. */
+
+static void window_expose( struct window *w, struct graphics_rect r )
+{
+	struct graphics_rect bounds = window_rect(w);
+
+	if(!w->visible) return;
+	if(!window_intersect(&r, &bounds)) return;
+	window_expose_above(w->node.next, w, r, 1);
+}
+
+/* Redraw screen area r from the stores, clearing the desktop too if asked. */
+
+static void window_repaint( struct graphics_rect r, int desktop )
+{
+	struct list_node *n;
+
+	if(desktop) window_expose_above(window_stack.head, 0, r, 1);
+
+	for(n = window_stack.head; n; n = n->next) {
+		window_expose((struct window *) n, r);
+	}
+}
+
+/* After the stacking order changes, note which windows are completely covered. */
+
+static void window_restack()
+{
+	struct list_node *n;
+
+	for(n = window_stack.head; n; n = n->next) {
+		struct window *w = (struct window *) n;
+		w->visible = window_expose_above(n->next, w, window_rect(w), 0) > 0;
+	}
+}
+
 struct window * window_create( struct window *parent, int x, int y, int width, int height )
 {
+	if(x < 0 || y < 0 || width <= 0 || height <= 0) return 0;
+	if(x + width > window_width(parent) || y + height > window_height(parent)) return 0;
+
 	struct window *w = kmalloc(sizeof(*w));
+	if(!w) return 0;
+
+	memset(w, 0, sizeof(*w));
 	w->parent = parent;
-	w->graphics = graphics_create(parent->graphics);
-	graphics_clip(w->graphics,x,y,width,height);
+	w->x = x;
+	w->y = y;
+
+	if(parent == &window_root) {
+		if(!window_screen) {
+			struct graphics_color black = { 0, 0, 0, 0 };
+			window_screen = graphics_create(window_root.graphics);
+			if(window_screen) {
+				/* Compositor output is not a change to the desktop. */
+				graphics_own_damage(window_screen);
+				graphics_bgcolor(window_screen, black);
+			}
+		}
+		if(window_screen) {
+			w->store = bitmap_create_paged(width, height, graphics_format(parent->graphics));
+		}
+		if(w->store) {
+			w->graphics = graphics_create_bitmap(w->store);
+			if(!w->graphics) {
+				bitmap_delete(w->store);
+				w->store = 0;
+			}
+		}
+	}
+
+	if(!w->graphics) {
+		w->graphics = graphics_create(parent->graphics);
+		if(!w->graphics) {
+			kfree(w);
+			return 0;
+		}
+		graphics_clip(w->graphics,x,y,width,height);
+	}
+
 	w->queue = event_queue_create();
 	w->refcount = 1;
 	w->parent->refcount++;
+
+	if(w->store) {
+		list_push_tail(&window_stack, &w->node);
+		window_restack();
+		window_expose(w, window_rect(w));
+	}
+
 	return w;
 }
-
 struct window * window_addref( struct window *w )
 {
 	w->refcount++;
@@ -49,8 +258,15 @@ void window_delete( struct window *w )
 
 	w->refcount--;
 	if(w->refcount==0) {
+		if(w->store) {
+			list_remove(&w->node);
+			window_restack();
+			window_repaint(window_rect(w), 1);
+		}
 		graphics_delete(w->graphics);
 		event_queue_delete(w->queue);
+		if(w->surface) bitmap_delete(w->surface);
+		if(w->store) bitmap_delete(w->store);
 		window_delete(w->parent);
 		kfree(w);
 	}
@@ -95,9 +311,108 @@ int  window_read_events_nonblock( struct window *w, struct event *e, int size )
 	return event_queue_read_nonblock(w->queue,e,size);
 }
 
+/* The top level window that the drawing of w lands in, or the root. */
+
+static struct window * window_top( struct window *w )
+{
+	while(w != &window_root && w->parent != &window_root) w = w->parent;
+	return w;
+}
+
+void window_update( struct window *w )
+{
+	struct graphics_rect r;
+
+	w = window_top(w);
+	if(!graphics_take_damage(w->graphics, &r)) return;
+
+	if(w->store) {
+		r.x += w->x;
+		r.y += w->y;
+		window_expose(w, r);
+	} else {
+		/* The desktop changed, and may have been drawn over windows. */
+		window_repaint(r, 0);
+	}
+}
+
 int  window_write_graphics( struct window *w, int *cmd, int size )
 {
-	return graphics_write(w->graphics,cmd,size);	
+	int result = graphics_write(w->graphics,cmd,size);
+	window_update(w);
+	return result;
 }
 
+int  window_move( struct window *w, int x, int y )
+{
+	struct graphics_rect old, parts[4];
+	int i, count;
 
+	if(!w->store) return KERROR_NOT_IMPLEMENTED;
+
+	/* Some part must stay on the screen, which also keeps the rectangle arithmetic in range. */
+	if(x <= -window_width(w) || x >= window_width(w->parent)) return KERROR_INVALID_REQUEST;
+	if(y <= -window_height(w) || y >= window_height(w->parent)) return KERROR_INVALID_REQUEST;
+
+	old = window_rect(w);
+	w->x = x;
+	w->y = y;
+	window_restack();
+	window_expose(w, window_rect(w));
+
+	count = window_subtract(old, window_rect(w), parts);
+	for(i = 0; i < count; i++) {
+		window_repaint(parts[i], 1);
+	}
+
+	return 0;
+}
+
+int  window_raise( struct window *w )
+{
+	if(!w->store) return KERROR_NOT_IMPLEMENTED;
+
+	list_remove(&w->node);
+	list_push_tail(&window_stack, &w->node);
+	window_restack();
+	window_expose(w, window_rect(w));
+	return 0;
+}
+
+struct bitmap * window_surface( struct window *w )
+{
+	if(w->store) return w->store;
+
+	if(!w->surface) {
+		w->surface = bitmap_create_paged(window_width(w),window_height(w),graphics_format(w->graphics));
+	}
+	return w->surface;
+}
+
+int  window_present( struct window *w, const struct graphics_rect *rects, int count )
+{
+	int i;
+
+	/* The surface of a composited window is its store, so only the screen needs updating. */
+	if(w->store) {
+		for(i=0;i<count;i++) {
+			struct graphics_rect r = rects[i];
+			struct graphics_rect bounds = { 0, 0, window_width(w), window_height(w) };
+			if(!window_intersect(&r,&bounds)) continue;
+			r.x += w->x;
+			r.y += w->y;
+			window_expose(w,r);
+		}
+		return count;
+	}
+
+	if(!w->surface) return KERROR_INVALID_REQUEST;
+
+	for(i=0;i<count;i++) {
+		const struct graphics_rect *r = &rects[i];
+		graphics_blit_rect(w->graphics,r->x,r->y,w->surface,r->x,r->y,r->w,r->h,0);
+	}
+	window_update(w);
+
+	return count;
+}
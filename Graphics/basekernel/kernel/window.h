@@ -21,6 +21,28 @@ int  window_read_events( struct window *w, struct event *e, int size );
 int  window_read_events_nonblock( struct window *w, struct event *e, int size );
 int  window_write_graphics( struct window *w, int *cmd, int size );
 
+/*
+Windows on the root window are composited from backing stores.
+window_update copies whatever was drawn into w since the last update
+to the visible parts of the screen.  window_move and window_raise
+change the position and stacking order of a composited window
+without asking its program to redraw.  A move that would take the
+window entirely off the screen is refused.
+*/
+
+void window_update( struct window *w );
+int  window_move( struct window *w, int x, int y );
+int  window_raise( struct window *w );
+
+/*
+A window may have a pixel surface in the screen's format, created on
+first use, which a process draws into directly.  window_present copies
+the given rectangles of the surface to the window.
+*/
+
+struct bitmap * window_surface( struct window *w );
+int  window_present( struct window *w, const struct graphics_rect *rects, int count );
+
 void window_event_post_root( uint16_t type, uint16_t code, int16_t x, int16_t y );
 
 #endif
@@ -9,6 +9,10 @@
 #include "library/malloc.h"
 #include "library/stdio.h"
 
+#define NW_CHAR_WIDTH 8
+#define NW_TEXT_CHUNK 256
+#define NW_SPAN_CHUNK 256
+
 struct nwindow {
 	int fd;
 	int x, y;
@@ -18,6 +22,8 @@ struct nwindow {
 		int length;
 		int index;
 	} graphics;
+	struct graphics_surface surface;
+	int has_surface;
 };
 
 struct nwindow * nw_create_fd( int fd )
@@ -27,8 +33,9 @@ struct nwindow * nw_create_fd( int fd )
 	w->x = 0;
 	w->y = 0;
 	w->graphics.buffer = malloc(PAGE_SIZE);
-	w->graphics.length = PAGE_SIZE;
+	w->graphics.length = PAGE_SIZE/sizeof(int);
 	w->graphics.index = 0;
+	w->has_surface = 0;
 
 	int dims[2];
 	syscall_object_size(fd,dims,2);
@@ -99,31 +106,79 @@ int nw_fd( struct nwindow *w )
 	return w->fd;
 }
 
-static void nw_draw3( struct nwindow *nw, int t, int a0, int a1, int a2 )
+int nw_move( struct nwindow *nw, int x, int y )
 {
-	if(nw->graphics.length-nw->graphics.index<4) {
-		nw_flush(nw);
+	if(nw->graphics.index>0) nw_flush(nw);
+	int r = syscall_window_move(nw->fd,x,y);
+	if(r>=0) {
+		nw->x = x;
+		nw->y = y;
 	}
-	int *p = &nw->graphics.buffer[nw->graphics.index];
-	*p++ = t;
-	*p++ = a0;
-	*p++ = a1;
-	*p++ = a2;
-	nw->graphics.index += 4;
+	return r;
 }
 
-static void nw_draw4( struct nwindow *nw, int t, int a0, int a1, int a2, int a3 )
+int nw_raise( struct nwindow *nw )
+{
+	if(nw->graphics.index>0) nw_flush(nw);
+	return syscall_window_raise(nw->fd);
+}
+
+/* Arguments can be packed two to a word when they all fit in 16 bits. */
+
+static int nw_packable( const int *args, int n )
 {
-	if(nw->graphics.length-nw->graphics.index<5) {
+	int i;
+	for(i=0;i<n;i++) {
+		if(args[i]<-32768 || args[i]>32767) return 0;
+	}
+	return 1;
+}
+
+/*
+Append command t with n arguments, leaving room for extra words of
+trailing data, and return where that data goes.
+*/
+
+static int * nw_command( struct nwindow *nw, int t, const int *args, int n, int packed, int extra )
+{
+	int i;
+	int words = 1 + (packed ? (n+1)/2 : n) + extra;
+
+	if(nw->graphics.length-nw->graphics.index<words) {
 		nw_flush(nw);
 	}
+
 	int *p = &nw->graphics.buffer[nw->graphics.index];
-	*p++ = t;
-	*p++ = a0;
-	*p++ = a1;
-	*p++ = a2;
-	*p++ = a3;
-	nw->graphics.index += 5;
+	if(packed) {
+		*p++ = t | GRAPHICS_PACKED;
+		for(i=0;i<n;i+=2) {
+			uint32_t hi = i+1<n ? args[i+1] : 0;
+			*p++ = (args[i] & 0xffff) | (hi << 16);
+		}
+	} else {
+		*p++ = t;
+		for(i=0;i<n;i++) *p++ = args[i];
+	}
+
+	nw->graphics.index += words;
+	return p;
+}
+
+static void nw_drawn( struct nwindow *nw, int t, const int *args, int n )
+{
+	nw_command(nw,t,args,n,nw_packable(args,n),0);
+}
+
+static void nw_draw3( struct nwindow *nw, int t, int a0, int a1, int a2 )
+{
+	int args[3] = { a0, a1, a2 };
+	nw_drawn(nw,t,args,3);
+}
+
+static void nw_draw4( struct nwindow *nw, int t, int a0, int a1, int a2, int a3 )
+{
+	int args[4] = { a0, a1, a2, a3 };
+	nw_drawn(nw,t,args,4);
 }
 
 void nw_flush( struct nwindow *nw )
@@ -132,6 +187,25 @@ void nw_flush( struct nwindow *nw )
 	nw->graphics.index = 0;
 }
 
+struct graphics_surface * nw_surface( struct nwindow *nw )
+{
+	/* Commands queued so far must land before the caller writes any pixels. */
+	if(nw->graphics.index>0) nw_flush(nw);
+
+	if(!nw->has_surface) {
+		if(syscall_window_surface(nw->fd,&nw->surface)<0) return 0;
+		nw->has_surface = 1;
+	}
+	return &nw->surface;
+}
+
+void nw_present( struct nwindow *nw, const struct graphics_rect *rects, int count )
+{
+	/* Queued commands are shown too, drawn where they fall in call order. */
+	if(nw->graphics.index>0) nw_flush(nw);
+	syscall_window_present(nw->fd,rects,count);
+}
+
 void nw_fgcolor( struct nwindow *nw, int r, int g, int b)
 {
 	nw_draw3(nw,GRAPHICS_FGCOLOR, r, g, b);
@@ -161,20 +235,104 @@ void nw_string( struct nwindow *nw, int x, int y, const char *s )
 {
 	int length = strlen(s);
 
-	if(nw->graphics.length-nw->graphics.index < (length+4) ) {
-		nw_flush(nw);
+	/* Long strings go out in pieces so each one fits in the buffer. */
+	while(length>0) {
+		int n = length<NW_TEXT_CHUNK ? length : NW_TEXT_CHUNK;
+		int args[3] = { x, y, n };
+		int packed = nw_packable(args,3);
+		int *p = nw_command(nw,GRAPHICS_TEXT,args,3,packed,packed ? (n+3)/4 : n);
+		int i;
+
+		if(packed) {
+			for(i=0;i<n;i+=4) {
+				int j, word = 0;
+				for(j=0;j<4 && i+j<n;j++) {
+					word |= (uint8_t) s[i+j] << (8*j);
+				}
+				*p++ = word;
+			}
+		} else {
+			for(i=0;i<n;i++) *p++ = s[i];
+		}
+
+		x += n*NW_CHAR_WIDTH;
+		s += n;
+		length -= n;
 	}
+}
 
-	int *p = &nw->graphics.buffer[nw->graphics.index];
-	*p++ = GRAPHICS_TEXT;
-	*p++ = x;
-	*p++ = y;
-	*p++ = length;
+void nw_char( struct nwindow *nw, int x, int y, char c )
+{
+	char s[2] = { c, 0 };
+	nw_string(nw,x,y,s);
+}
 
-	int i;
-	for(i=0;i<length;i++) {
-		*p++ = s[i];
+void nw_tri( struct nwindow *nw, int x0, int y0, int x1, int y1, int x2, int y2 )
+{
+	int args[6] = { x0, y0, x1, y1, x2, y2 };
+	nw_drawn(nw,GRAPHICS_TRI,args,6);
+}
+
+void nw_circle( struct nwindow *nw, int x, int y, int r )
+{
+	nw_draw3(nw,GRAPHICS_CIRCLE,x,y,r);
+}
+
+void nw_spans( struct nwindow *nw, int y, const int *x1, const int *x2, int count )
+{
+	while(count>0) {
+		int n = count<NW_SPAN_CHUNK ? count : NW_SPAN_CHUNK;
+		int args[2] = { y, n };
+		int i, packed = nw_packable(args,2) && nw_packable(x1,n) && nw_packable(x2,n);
+		int *p = nw_command(nw,GRAPHICS_SPANS,args,2,packed,packed ? n : 2*n);
+
+		for(i=0;i<n;i++) {
+			if(packed) {
+				*p++ = (x1[i] & 0xffff) | ((uint32_t) x2[i] << 16);
+			} else {
+				*p++ = x1[i];
+				*p++ = x2[i];
+			}
+		}
+
+		y += n;
+		x1 += n;
+		x2 += n;
+		count -= n;
 	}
+}
+
+void nw_copy_area( struct nwindow *nw, int sx, int sy, int w, int h, int dx, int dy )
+{
+	int args[6] = { sx, sy, w, h, dx, dy };
+	nw_drawn(nw,GRAPHICS_COPY_AREA,args,6);
+}
+
+int nw_upload( struct nwindow *nw, int handle, int width, int height, const int *pixels )
+{
+	if(handle<0 || handle>=GRAPHICS_BITMAP_HANDLES) return -1;
+	if(width<=0 || width>GRAPHICS_BITMAP_MAX_SIZE) return -1;
+	if(height<=0 || height>GRAPHICS_BITMAP_MAX_SIZE) return -1;
+
+	/* A bitmap can be larger than the command buffer, so it goes in its own write. */
+	int n = width*height;
+	int *m = malloc((4+n)*sizeof(int));
+	if(!m) return -1;
 
-	nw->graphics.index += 4 + length;
+	m[0] = GRAPHICS_UPLOAD;
+	m[1] = handle;
+	m[2] = width;
+	m[3] = height;
+	memcpy(&m[4],pixels,n*sizeof(int));
+
+	if(nw->graphics.index>0) nw_flush(nw);
+	int r = syscall_object_write(nw->fd,m,4+n,0);
+	free(m);
+	return r;
+}
+
+void nw_blit( struct nwindow *nw, int handle, int x, int y, int keyed )
+{
+	int args[4] = { handle, x, y, keyed };
+	nw_drawn(nw,GRAPHICS_BLIT,args,4);
 }
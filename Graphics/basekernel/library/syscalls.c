@@ -108,6 +108,26 @@ int syscall_open_pipe()
 	return syscall(SYSCALL_OPEN_PIPE, 0, 0, 0, 0, 0);
 }
 
+int syscall_window_surface(int fd, struct graphics_surface *s)
+{
+	return syscall(SYSCALL_WINDOW_SURFACE, fd, (uint32_t) s, 0, 0, 0);
+}
+
+int syscall_window_present(int fd, const struct graphics_rect *rects, int count)
+{
+	return syscall(SYSCALL_WINDOW_PRESENT, fd, (uint32_t) rects, count, 0, 0);
+}
+
+int syscall_window_move(int fd, int x, int y)
+{
+	return syscall(SYSCALL_WINDOW_MOVE, fd, x, y, 0, 0);
+}
+
+int syscall_window_raise(int fd)
+{
+	return syscall(SYSCALL_WINDOW_RAISE, fd, 0, 0, 0, 0);
+}
+
 int syscall_object_type(int fd)
 {
 	return syscall(SYSCALL_OBJECT_TYPE, fd, 0, 0, 0, 0);
@@ -13,8 +13,10 @@ See the file LICENSE for details.
 
 int in_set( float x, float y );
 void plot_point(int iter, int j, int k);
+void iter_color(int iter, int color[3]);
 
 struct nwindow *nw = 0;
+struct graphics_surface *surface = 0;
 
 int main(int argc, char *argv[])
 {
@@ -26,6 +28,9 @@ int main(int argc, char *argv[])
 
 	nw_clear(nw,0,0,xsize,ysize);
 
+	/* Draw straight into the window's pixels if the kernel can map them. */
+	surface = nw_surface(nw);
+
 	float xlow = -2.0;
 	float ylow = -1.5;
 	float xfactor = 2.5/xsize;
@@ -41,6 +46,12 @@ int main(int argc, char *argv[])
 			float y = j*yfactor + ylow;
 			iter = in_set(x,y);
 			plot_point(iter,i,j);
+		}
+		if(surface) {
+			/* One present per column instead of a command per pixel. */
+			struct graphics_rect r = { i, 0, 1, ysize };
+			nw_present(nw,&r,1);
+		} else {
 			nw_flush(nw);
 		}
 		syscall_process_yield();
@@ -64,16 +75,29 @@ int in_set( float x0, float y0 )
 	return i;
 }
 
-void plot_point(int iter, int j, int k)
+void iter_color(int iter, int color[3])
 {
 	if(iter==MAX_ITERS) {
-		nw_fgcolor(nw,0,0,0);
+		color[0] = color[1] = color[2] = 0;
 	} else {
-		int color[3];
 		color[0] = iter   % 256;
 		color[1] = iter*3 % 256;
 		color[2] = iter*7 % 256;
+	}
+}
+
+void plot_point(int iter, int j, int k)
+{
+	int color[3];
+	iter_color(iter,color);
+
+	if(surface) {
+		unsigned char *p = surface->pixels + k*surface->pitch + j*surface->bpp;
+		p[0] = color[2];
+		p[1] = color[1];
+		p[2] = color[0];
+	} else {
 		nw_fgcolor(nw,color[0],color[1],color[2]);
+		nw_rect(nw,j,k,1,1);
 	}
-	nw_rect(nw,j,k,1,1);
 }
@@ -38,6 +38,7 @@ struct window {
 	int argc;
 	int pid;
 	int fds[6];
+	struct nwindow *child;
 };
 
 struct nwindow *nw = 0;
@@ -113,6 +114,7 @@ int main(int argc, char *argv[])
 		struct window *w = &windows[i];
 
 		struct nwindow *child = nw_create_child(nw,w->x+WINDOW_BORDER, w->y+WINDOW_TITLE_HEIGHT, w->w-WINDOW_BORDER*2, w->h-WINDOW_BORDER-WINDOW_TITLE_HEIGHT);
+		w->child = child;
 
 		int window_fd = nw_fd(child);
 
@@ -184,9 +186,10 @@ int main(int argc, char *argv[])
 			nw_flush(nw);
 			active = (active + 1) % NWINDOWS;
 
-			/* Draw green window around new window. */
+			/* Draw green window around new window, and bring it to the front. */
 			draw_border(&windows[active],1);
 			nw_flush(nw);
+			nw_raise(windows[active].child);
 		} else if (c=='~') {
 			/* If tilde entered, cancel the whole thing. */
 			break;